@@ -0,0 +1,529 @@
+// bench_client.cpp
+// Load generator for the server: N connections spread over M threads, each
+// thread driving its connections through one epoll loop.
+//
+//   closed loop (default): a connection sends its next request as soon as a
+//                          reply arrives (up to --pipeline in flight)
+//   open loop (--rate R):  requests arrive on a fixed schedule, R per second
+//                          in total; latency is measured from the scheduled
+//                          time, so a stalled server is not hidden by the
+//                          client backing off (coordinated omission)
+//
+// --protocol http talks to the HTTP handler (one request per connection,
+// as the server closes after each response). --protocol resp speaks RESP
+// over persistent, optionally pipelined connections.
+#include "../src/stats/histogram.hpp"
+#include "key_chooser.hpp"
+#include "resp.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    bool resp = false;
+    int connections = 50;
+    int threads = 4;
+    int pipeline = 1;
+    double duration_s = 10;
+    double rate = 0;            // Requests per second in total; 0 = closed loop
+    uint64_t keys = 100000;
+    KeyChooser::Kind dist = KeyChooser::UNIFORM;
+    double theta = ZipfianChooser::DEFAULT_THETA;
+    size_t value_min = 64;
+    size_t value_max = 64;
+    double get_ratio = 0.8;
+    std::string key_prefix = "key:";
+    bool json = false;
+};
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void usage(const char* prog) {
+    std::cerr <<
+        "Usage: " << prog << " [options]\n"
+        "  --host HOST            server address (default 127.0.0.1)\n"
+        "  --port PORT            server port (default 8080)\n"
+        "  --protocol http|resp   wire protocol (default http)\n"
+        "  --connections N        open connections (default 50)\n"
+        "  --threads M            client threads (default 4)\n"
+        "  --pipeline D           requests in flight per connection, RESP only (default 1)\n"
+        "  --duration SECONDS     run time (default 10)\n"
+        "  --rate R               open loop at R requests/s in total (default: closed loop)\n"
+        "  --keys K               key space size (default 100000)\n"
+        "  --dist uniform|zipf    key distribution (default uniform)\n"
+        "  --theta T              zipf skew, 0 < T < 1 (default 0.99)\n"
+        "  --value-size N|MIN-MAX value bytes for writes (default 64)\n"
+        "  --mix get:G,set:S      read/write ratio (default get:80,set:20)\n"
+        "  --key-prefix P         key prefix (default \"key:\")\n"
+        "  --json                 print the report as JSON\n";
+}
+
+void parse_mix(const std::string& mix, Options& opt) {
+    double get = 0, set = 0;
+    size_t start = 0;
+    while (start < mix.size()) {
+        size_t end = mix.find(',', start);
+        std::string part = mix.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        size_t colon = part.find(':');
+        if (colon == std::string::npos) throw std::invalid_argument("bad --mix entry: " + part);
+        std::string op = part.substr(0, colon);
+        double weight = std::stod(part.substr(colon + 1));
+        if (op == "get") get = weight;
+        else if (op == "set") set = weight;
+        else throw std::invalid_argument("unknown --mix operation: " + op);
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+    if (get + set <= 0) throw std::invalid_argument("--mix needs a positive weight");
+    opt.get_ratio = get / (get + set);
+}
+
+Options parse_args(int argc, char** argv) {
+    enum { HOST = 1, PORT, PROTOCOL, CONNECTIONS, THREADS, PIPELINE, DURATION, RATE,
+           KEYS, DIST, THETA, VALUE_SIZE, MIX, KEY_PREFIX, JSON, HELP };
+    static const option long_options[] = {
+        {"host", required_argument, nullptr, HOST},
+        {"port", required_argument, nullptr, PORT},
+        {"protocol", required_argument, nullptr, PROTOCOL},
+        {"connections", required_argument, nullptr, CONNECTIONS},
+        {"threads", required_argument, nullptr, THREADS},
+        {"pipeline", required_argument, nullptr, PIPELINE},
+        {"duration", required_argument, nullptr, DURATION},
+        {"rate", required_argument, nullptr, RATE},
+        {"keys", required_argument, nullptr, KEYS},
+        {"dist", required_argument, nullptr, DIST},
+        {"theta", required_argument, nullptr, THETA},
+        {"value-size", required_argument, nullptr, VALUE_SIZE},
+        {"mix", required_argument, nullptr, MIX},
+        {"key-prefix", required_argument, nullptr, KEY_PREFIX},
+        {"json", no_argument, nullptr, JSON},
+        {"help", no_argument, nullptr, HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    Options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        std::string arg = optarg ? optarg : "";
+        switch (c) {
+            case HOST: opt.host = arg; break;
+            case PORT: opt.port = std::stoi(arg); break;
+            case PROTOCOL:
+                if (arg == "resp") opt.resp = true;
+                else if (arg != "http") throw std::invalid_argument("unknown protocol: " + arg);
+                break;
+            case CONNECTIONS: opt.connections = std::stoi(arg); break;
+            case THREADS: opt.threads = std::stoi(arg); break;
+            case PIPELINE: opt.pipeline = std::stoi(arg); break;
+            case DURATION: opt.duration_s = std::stod(arg); break;
+            case RATE: opt.rate = std::stod(arg); break;
+            case KEYS: opt.keys = std::stoull(arg); break;
+            case DIST: opt.dist = KeyChooser::parse_kind(arg); break;
+            case THETA: opt.theta = std::stod(arg); break;
+            case VALUE_SIZE: {
+                size_t dash = arg.find('-');
+                opt.value_min = std::stoul(arg.substr(0, dash));
+                opt.value_max = dash == std::string::npos ? opt.value_min : std::stoul(arg.substr(dash + 1));
+                break;
+            }
+            case MIX: parse_mix(arg, opt); break;
+            case KEY_PREFIX: opt.key_prefix = arg; break;
+            case JSON: opt.json = true; break;
+            case HELP: usage(argv[0]); std::exit(EXIT_SUCCESS);
+            default: usage(argv[0]); std::exit(EXIT_FAILURE);
+        }
+    }
+    if (opt.connections < 1 || opt.threads < 1 || opt.pipeline < 1 || opt.keys < 1 ||
+        opt.value_max < opt.value_min || opt.duration_s <= 0) {
+        throw std::invalid_argument("invalid option value");
+    }
+    if (!(opt.theta > 0 && opt.theta < 1)) throw std::invalid_argument("--theta must be in (0, 1)");
+    opt.threads = std::min(opt.threads, opt.connections);
+    if (!opt.resp && opt.pipeline > 1) {
+        std::cerr << "note: --pipeline applies to RESP only; HTTP sends one request per connection\n";
+        opt.pipeline = 1;
+    }
+    return opt;
+}
+
+struct Totals {
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    uint64_t bytes_out = 0;
+    uint64_t bytes_in = 0;
+};
+
+class Worker {
+public:
+    Worker(const Options& opt, const sockaddr_in& addr, int connections, const KeyChooser& chooser,
+           uint64_t seed, uint64_t end_ns)
+        : opt_(opt), addr_(addr), conns_(connections), chooser_(chooser), rng_(seed), end_ns_(end_ns),
+          value_(opt.value_max, 'x') {
+        epoll_fd_ = epoll_create1(0);
+        if (epoll_fd_ < 0) throw std::runtime_error("epoll_create1 failed");
+        if (opt_.rate > 0) {
+            // Each connection gets an equal share of the rate, with a random phase
+            interval_ns_ = static_cast<uint64_t>(1e9 * opt_.connections / opt_.rate);
+            std::uniform_int_distribution<uint64_t> phase(0, interval_ns_);
+            uint64_t start = now_ns();
+            for (auto& c : conns_) c.next_send_ns = start + phase(rng_);
+        }
+    }
+
+    ~Worker() {
+        for (auto& c : conns_) close_conn(c);
+        close(epoll_fd_);
+    }
+
+    void run() {
+        epoll_event events[256];
+        while (true) {
+            uint64_t now = now_ns();
+            if (now >= end_ns_) break;
+
+            uint64_t wake = std::min(end_ns_, now + 10'000'000);
+            for (size_t i = 0; i < conns_.size(); ++i) {
+                fill(i, now);
+                Conn& c = conns_[i];
+                if (opt_.rate > 0 && c.pending.size() < depth()) wake = std::min(wake, c.next_send_ns);
+                if (c.retry_at_ns) wake = std::min(wake, c.retry_at_ns);
+            }
+
+            int timeout_ms = wake > now ? static_cast<int>((wake - now + 999'999) / 1'000'000) : 0;
+            int n = epoll_wait(epoll_fd_, events, 256, timeout_ms);
+            for (int e = 0; e < n; ++e) on_event(events[e].data.u32, events[e].events);
+        }
+        // Requests still in flight when time is up are not counted
+    }
+
+    const stats::LogLinearHistogram& histogram() const { return hist_; }
+    const Totals& totals() const { return totals_; }
+
+private:
+    struct Conn {
+        int fd = -1;
+        bool connecting = false;
+        std::string out;
+        size_t out_pos = 0;
+        std::string in;
+        std::deque<uint64_t> pending; // Intended start time of each request in flight
+        uint64_t next_send_ns = 0;    // Open loop: next scheduled arrival
+        uint64_t retry_at_ns = 0;     // Back-off after a failed connect
+    };
+
+    const Options& opt_;
+    sockaddr_in addr_;
+    std::vector<Conn> conns_;
+    KeyChooser chooser_;
+    std::mt19937_64 rng_;
+    uint64_t end_ns_;
+    uint64_t interval_ns_ = 0;
+    std::string value_;
+    int epoll_fd_ = -1;
+    stats::LogLinearHistogram hist_;
+    Totals totals_;
+
+    size_t depth() const { return static_cast<size_t>(opt_.pipeline); }
+
+    bool open_conn(size_t index) {
+        Conn& c = conns_[index];
+        c.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (c.fd < 0) return false;
+        int one = 1;
+        setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        int rc = connect(c.fd, reinterpret_cast<const sockaddr*>(&addr_), sizeof(addr_));
+        if (rc < 0 && errno != EINPROGRESS) {
+            close(c.fd);
+            c.fd = -1;
+            return false;
+        }
+        c.connecting = rc < 0;
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.u32 = static_cast<uint32_t>(index);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, c.fd, &ev);
+        return true;
+    }
+
+    void close_conn(Conn& c) {
+        if (c.fd >= 0) {
+            close(c.fd); // Also removes it from the epoll set
+            c.fd = -1;
+        }
+        c.connecting = false;
+        c.out.clear();
+        c.out_pos = 0;
+        c.in.clear();
+    }
+
+    void fail_conn(Conn& c) {
+        totals_.errors += c.pending.size();
+        c.pending.clear();
+        close_conn(c);
+        c.retry_at_ns = now_ns() + 10'000'000; // Do not hammer a refusing server
+    }
+
+    void append_request(Conn& c) {
+        uint64_t key = chooser_.next(rng_);
+        std::string k = opt_.key_prefix + std::to_string(key);
+        bool is_get = std::uniform_real_distribution<double>(0, 1)(rng_) < opt_.get_ratio;
+        size_t vlen = opt_.value_min == opt_.value_max ? opt_.value_min
+            : std::uniform_int_distribution<size_t>(opt_.value_min, opt_.value_max)(rng_);
+
+        if (opt_.resp) {
+            if (is_get) {
+                c.out += "*2\r\n$3\r\nGET\r\n$" + std::to_string(k.size()) + "\r\n" + k + "\r\n";
+            } else {
+                c.out += "*3\r\n$3\r\nSET\r\n$" + std::to_string(k.size()) + "\r\n" + k + "\r\n$" +
+                         std::to_string(vlen) + "\r\n";
+                c.out.append(value_, 0, vlen);
+                c.out += "\r\n";
+            }
+        } else if (is_get) {
+            c.out += "GET /" + k + " HTTP/1.1\r\nHost: " + opt_.host + "\r\n\r\n";
+        } else {
+            c.out += "POST /" + k + " HTTP/1.1\r\nHost: " + opt_.host + "\r\nContent-Length: " +
+                     std::to_string(vlen) + "\r\n\r\n";
+            c.out.append(value_, 0, vlen);
+        }
+    }
+
+    // Queues every request this connection may send now
+    void fill(size_t index, uint64_t now) {
+        Conn& c = conns_[index];
+        if (c.retry_at_ns) {
+            if (now < c.retry_at_ns) return;
+            c.retry_at_ns = 0;
+        }
+
+        bool queued = false;
+        while (c.pending.size() < depth()) {
+            uint64_t intended = now;
+            if (opt_.rate > 0) {
+                if (c.next_send_ns > now) break;
+                intended = c.next_send_ns; // Late sends still count from the schedule
+                c.next_send_ns += interval_ns_;
+            }
+            if (c.fd < 0 && !open_conn(index)) {
+                totals_.errors++;
+                c.retry_at_ns = now + 10'000'000;
+                return;
+            }
+            append_request(c);
+            c.pending.push_back(intended);
+            queued = true;
+        }
+        if (queued && !c.connecting) flush(c);
+    }
+
+    void flush(Conn& c) {
+        while (c.out_pos < c.out.size()) {
+            ssize_t n = send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                fail_conn(c);
+                return;
+            }
+            c.out_pos += static_cast<size_t>(n);
+            totals_.bytes_out += static_cast<uint64_t>(n);
+        }
+        c.out.clear();
+        c.out_pos = 0;
+    }
+
+    void on_event(uint32_t index, uint32_t events) {
+        Conn& c = conns_[index];
+        if (c.fd < 0) return;
+
+        if (c.connecting && (events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                fail_conn(c);
+                return;
+            }
+            c.connecting = false;
+        }
+        if (!c.connecting && (events & EPOLLOUT)) flush(c);
+        if (c.fd >= 0 && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) read_replies(c);
+    }
+
+    void complete(Conn& c, bool ok) {
+        uint64_t intended = c.pending.front();
+        c.pending.pop_front();
+        if (ok) {
+            hist_.record(now_ns() - intended);
+            totals_.completed++;
+        } else {
+            totals_.errors++;
+        }
+    }
+
+    void read_replies(Conn& c) {
+        char buf[64 * 1024];
+        bool eof = false;
+        while (true) {
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                c.in.append(buf, static_cast<size_t>(n));
+                totals_.bytes_in += static_cast<uint64_t>(n);
+                continue;
+            }
+            if (n == 0) eof = true;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK) eof = true;
+            break;
+        }
+
+        if (opt_.resp) {
+            size_t used = 0;
+            while (!c.pending.empty()) {
+                size_t len = resp_reply_length(c.in.data() + used, c.in.size() - used);
+                if (len == 0) break;
+                complete(c, c.in[used] != '-');
+                used += len;
+            }
+            c.in.erase(0, used);
+            if (eof) fail_conn(c);
+            return;
+        }
+
+        // HTTP: one response per connection, delimited by Content-Length or EOF
+        size_t header_end = c.in.find("\r\n\r\n");
+        if (header_end != std::string::npos && !c.pending.empty()) {
+            size_t body_len = std::string::npos;
+            std::string head = c.in.substr(0, header_end);
+            std::transform(head.begin(), head.end(), head.begin(), [](unsigned char ch) { return std::tolower(ch); });
+            size_t cl = head.find("\r\ncontent-length:");
+            if (cl != std::string::npos) {
+                try {
+                    body_len = std::stoul(head.substr(cl + 17));
+                } catch (const std::logic_error&) {
+                    // Malformed Content-Length: a failed request, not a failed run
+                    complete(c, false);
+                    close_conn(c);
+                    return;
+                }
+            }
+
+            bool done = body_len != std::string::npos ? c.in.size() >= header_end + 4 + body_len : eof;
+            if (done) {
+                bool ok = c.in.compare(0, 9, "HTTP/1.1 ") == 0 && c.in.size() > 9 && c.in[9] == '2';
+                complete(c, ok);
+                close_conn(c);
+                return;
+            }
+        }
+        if (eof) fail_conn(c);
+    }
+};
+
+void report(const Options& opt, const stats::LogLinearHistogram::Snapshot& lat, const Totals& t, double elapsed_s) {
+    auto us = [](uint64_t ns) { return ns / 1e3; };
+    double rps = t.completed / elapsed_s;
+    if (opt.json) {
+        std::printf(
+            "{\"protocol\":\"%s\",\"mode\":\"%s\",\"connections\":%d,\"threads\":%d,\"pipeline\":%d,"
+            "\"duration_s\":%.3f,\"target_rate\":%.1f,\"requests\":%llu,\"errors\":%llu,"
+            "\"throughput_rps\":%.1f,\"bytes_out\":%llu,\"bytes_in\":%llu,"
+            "\"latency_us\":{\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f,\"mean\":%.1f}}\n",
+            opt.resp ? "resp" : "http", opt.rate > 0 ? "open" : "closed", opt.connections, opt.threads,
+            opt.pipeline, elapsed_s, opt.rate, static_cast<unsigned long long>(t.completed),
+            static_cast<unsigned long long>(t.errors), rps, static_cast<unsigned long long>(t.bytes_out),
+            static_cast<unsigned long long>(t.bytes_in), us(lat.percentile(0.5)), us(lat.percentile(0.9)),
+            us(lat.percentile(0.99)), us(lat.percentile(0.999)), us(lat.max),
+            lat.count ? us(lat.sum / lat.count) : 0.0);
+        return;
+    }
+    std::printf("%s %s loop: %d connections, %d threads, pipeline %d, %.1fs\n",
+                opt.resp ? "RESP" : "HTTP", opt.rate > 0 ? "open" : "closed",
+                opt.connections, opt.threads, opt.pipeline, elapsed_s);
+    if (opt.rate > 0) std::printf("  target rate:  %.1f req/s (latency from scheduled send time)\n", opt.rate);
+    std::printf("  requests:     %llu ok, %llu errors\n",
+                static_cast<unsigned long long>(t.completed), static_cast<unsigned long long>(t.errors));
+    std::printf("  throughput:   %.1f req/s, %.2f MB/s out, %.2f MB/s in\n",
+                rps, t.bytes_out / elapsed_s / 1e6, t.bytes_in / elapsed_s / 1e6);
+    std::printf("  latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                us(lat.percentile(0.5)), us(lat.percentile(0.9)), us(lat.percentile(0.99)),
+                us(lat.percentile(0.999)), us(lat.max));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(opt.host.c_str(), std::to_string(opt.port).c_str(), &hints, &res) != 0 || !res) {
+            throw std::runtime_error("cannot resolve " + opt.host);
+        }
+        sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+        freeaddrinfo(res);
+
+        KeyChooser chooser(opt.dist, opt.keys, opt.theta);
+        uint64_t start = now_ns();
+        uint64_t end = start + static_cast<uint64_t>(opt.duration_s * 1e9);
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int t = 0; t < opt.threads; ++t) {
+            int share = opt.connections / opt.threads + (t < opt.connections % opt.threads ? 1 : 0);
+            workers.push_back(std::make_unique<Worker>(opt, addr, share, chooser, 0x9e3779b97f4a7c15ull * (t + 1), end));
+        }
+
+        std::vector<std::thread> threads;
+        for (auto& w : workers) threads.emplace_back([&w] { w->run(); });
+        for (auto& th : threads) th.join();
+        double elapsed_s = (now_ns() - start) / 1e9;
+
+        stats::LogLinearHistogram::Snapshot latency;
+        Totals totals;
+        for (auto& w : workers) {
+            w->histogram().merge_into(latency);
+            totals.completed += w->totals().completed;
+            totals.errors += w->totals().errors;
+            totals.bytes_out += w->totals().bytes_out;
+            totals.bytes_in += w->totals().bytes_in;
+        }
+        report(opt, latency, totals, elapsed_s);
+        return totals.completed > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::cerr << "bench_client: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,296 @@
+// ds_bench.cpp
+// Data-structure benchmark for keyspace candidates.
+//
+// The server does not have a keyspace yet, so this measures the
+// containers one could be built on: std::unordered_map at several
+// maximum load factors, and std::map. For each key size, value size and
+// key count (powers of ten from --min-keys to --max-keys) it times
+// insert, lookup, iterate and delete. It also reports the heap bytes held
+// per key, and cache misses per operation when perf_event_open is
+// permitted. Lookups follow a uniform or Zipfian key distribution.
+#include "../src/stats/perf_counters.hpp"
+#include "key_chooser.hpp"
+
+#include <getopt.h>
+#include <malloc.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --- Live heap accounting ---
+namespace {
+std::atomic<int64_t> g_live_bytes{0};
+}
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    g_live_bytes.fetch_add(static_cast<int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    g_live_bytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(p)), std::memory_order_relaxed);
+    std::free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+namespace {
+
+struct Options {
+    uint64_t min_keys = 1000;
+    uint64_t max_keys = 1000000;
+    std::vector<size_t> key_sizes = {16, 64};     // Swept like key counts
+    std::vector<size_t> value_sizes = {32, 1024};
+    uint64_t lookups = 1000000;
+    KeyChooser::Kind dist = KeyChooser::UNIFORM;
+    double theta = ZipfianChooser::DEFAULT_THETA;
+    std::string filter;
+    bool json = false;
+};
+
+struct Measurement {
+    double ns_per_op = 0;
+    double misses_per_op = -1; // -1 when hardware counters are unavailable
+};
+
+struct Row {
+    std::string container;
+    size_t key_size = 0;
+    size_t value_size = 0;
+    uint64_t keys = 0;
+    Measurement insert, lookup, iterate, erase;
+    double bytes_per_key = 0;
+};
+
+// Times `fn` running `ops` operations, with cache misses if available
+Measurement measure(stats::PerfCounters& perf, uint64_t ops, const std::function<void()>& fn) {
+    stats::PerfCounters::Reading before, after;
+    bool counted = perf.read(before);
+    auto t0 = std::chrono::steady_clock::now();
+    fn();
+    auto t1 = std::chrono::steady_clock::now();
+    counted = perf.read(after) && counted;
+
+    Measurement m;
+    m.ns_per_op = std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(ops);
+    if (counted) {
+        auto delta = stats::PerfCounters::diff(after, before);
+        m.misses_per_op = static_cast<double>(delta[stats::PerfCounters::CACHE_MISSES]) / static_cast<double>(ops);
+    }
+    return m;
+}
+
+std::string make_key(uint64_t i, size_t size) {
+    std::string key = "k" + std::to_string(i);
+    if (key.size() < size) key.append(size - key.size(), '_');
+    return key;
+}
+
+// Sink so the optimizer cannot drop lookups and iteration
+volatile size_t g_sink = 0;
+
+template <typename Map>
+Row run_container(const std::string& name, size_t key_size, size_t value_size, uint64_t n,
+                  const std::vector<std::string>& keys, const std::vector<uint32_t>& lookup_order,
+                  stats::PerfCounters& perf, const std::function<void(Map&, uint64_t)>& prepare) {
+    Row row;
+    row.container = name;
+    row.key_size = key_size;
+    row.value_size = value_size;
+    row.keys = n;
+    const std::string value(value_size, 'v');
+
+    int64_t heap_before = g_live_bytes.load();
+    {
+        Map map;
+        prepare(map, n);
+
+        row.insert = measure(perf, n, [&] {
+            for (uint64_t i = 0; i < n; ++i) map.emplace(keys[i], value);
+        });
+        row.bytes_per_key = static_cast<double>(g_live_bytes.load() - heap_before) / static_cast<double>(n);
+
+        row.lookup = measure(perf, lookup_order.size(), [&] {
+            size_t found = 0;
+            for (uint32_t i : lookup_order) found += map.find(keys[i]) != map.end();
+            g_sink = found;
+        });
+
+        row.iterate = measure(perf, n, [&] {
+            size_t total = 0;
+            for (const auto& kv : map) total += kv.second.size();
+            g_sink = total;
+        });
+
+        row.erase = measure(perf, n, [&] {
+            for (uint64_t i = 0; i < n; ++i) map.erase(keys[i]);
+        });
+    }
+    return row;
+}
+
+void print_rows(const std::vector<Row>& rows, const Options& opt, bool perf_ok) {
+    if (opt.json) {
+        std::printf("{\"suite\":\"ds_bench\",\"dist\":\"%s\",\"perf_counters\":%s,\"benchmarks\":[",
+                    opt.dist == KeyChooser::UNIFORM ? "uniform" : "zipf", perf_ok ? "true" : "false");
+        bool first = true;
+        for (const auto& r : rows) {
+            const std::pair<const char*, const Measurement*> ops[] = {
+                {"insert", &r.insert}, {"lookup", &r.lookup}, {"iterate", &r.iterate}, {"erase", &r.erase}};
+            for (const auto& [op, m] : ops) {
+                char misses[32] = "null";
+                if (m->misses_per_op >= 0) std::snprintf(misses, sizeof(misses), "%.3f", m->misses_per_op);
+                std::printf("%s{\"name\":\"%s/%s/k%zu/v%zu/%llu\",\"key_size\":%zu,\"value_size\":%zu,"
+                            "\"ns_per_op\":%.2f,\"cache_misses_per_op\":%s,\"bytes_per_key\":%.1f}",
+                            first ? "" : ",", r.container.c_str(), op, r.key_size, r.value_size,
+                            static_cast<unsigned long long>(r.keys), r.key_size, r.value_size, m->ns_per_op,
+                            misses, r.bytes_per_key);
+                first = false;
+            }
+        }
+        std::printf("]}\n");
+        return;
+    }
+
+    std::printf("%s lookups, cache misses: %s\n", opt.dist == KeyChooser::UNIFORM ? "uniform" : "zipfian",
+                perf_ok ? "perf_event_open" : "unavailable");
+    std::printf("%-24s %6s %7s %11s %10s %10s %10s %10s %10s %12s\n", "container", "key B", "value B", "keys",
+                "insert ns", "lookup ns", "iter ns", "erase ns", "lookup miss", "heap B/key");
+    for (const auto& r : rows) {
+        char misses[32] = "-";
+        if (r.lookup.misses_per_op >= 0) std::snprintf(misses, sizeof(misses), "%.2f", r.lookup.misses_per_op);
+        std::printf("%-24s %6zu %7zu %11llu %10.1f %10.1f %10.1f %10.1f %10s %12.1f\n", r.container.c_str(),
+                    r.key_size, r.value_size, static_cast<unsigned long long>(r.keys), r.insert.ns_per_op,
+                    r.lookup.ns_per_op, r.iterate.ns_per_op, r.erase.ns_per_op, misses, r.bytes_per_key);
+    }
+}
+
+// "16,64,256" -> {16, 64, 256}
+std::vector<size_t> parse_sizes(const std::string& text) {
+    std::vector<size_t> sizes;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        sizes.push_back(std::stoul(text.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return sizes;
+}
+
+Options parse_args(int argc, char** argv) {
+    enum { MIN_KEYS = 1, MAX_KEYS, KEY_SIZE, VALUE_SIZE, LOOKUPS, DIST, THETA, FILTER, JSON, HELP };
+    static const option long_options[] = {
+        {"min-keys", required_argument, nullptr, MIN_KEYS},
+        {"max-keys", required_argument, nullptr, MAX_KEYS},
+        {"key-size", required_argument, nullptr, KEY_SIZE},
+        {"value-size", required_argument, nullptr, VALUE_SIZE},
+        {"lookups", required_argument, nullptr, LOOKUPS},
+        {"dist", required_argument, nullptr, DIST},
+        {"theta", required_argument, nullptr, THETA},
+        {"filter", required_argument, nullptr, FILTER},
+        {"json", no_argument, nullptr, JSON},
+        {"help", no_argument, nullptr, HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+    Options opt;
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        switch (c) {
+            case MIN_KEYS: opt.min_keys = std::stoull(optarg); break;
+            case MAX_KEYS: opt.max_keys = std::stoull(optarg); break;
+            case KEY_SIZE: opt.key_sizes = parse_sizes(optarg); break;
+            case VALUE_SIZE: opt.value_sizes = parse_sizes(optarg); break;
+            case LOOKUPS: opt.lookups = std::stoull(optarg); break;
+            case DIST: opt.dist = KeyChooser::parse_kind(optarg); break;
+            case THETA: opt.theta = std::stod(optarg); break;
+            case FILTER: opt.filter = optarg; break;
+            case JSON: opt.json = true; break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " [--min-keys N] [--max-keys N] [--key-size B,B...]"
+                             " [--value-size B,B...] [--lookups N] [--dist uniform|zipf] [--theta T]"
+                             " [--filter NAME] [--json]\n"
+                             "Key counts sweep powers of ten; up to 10^8 needs tens of GB of RAM.\n"
+                             "Every combination of key and value size is run (default 16,64 and 32,1024).\n";
+                std::exit(c == HELP ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+    if (opt.min_keys < 1 || opt.max_keys < opt.min_keys || opt.lookups < 1) {
+        throw std::invalid_argument("invalid key range or lookup count");
+    }
+    if (opt.max_keys > UINT32_MAX) throw std::invalid_argument("--max-keys must fit in 32 bits");
+    if (!(opt.theta > 0 && opt.theta < 1)) throw std::invalid_argument("--theta must be in (0, 1)");
+    return opt;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+        stats::PerfCounters perf;
+
+        using HashMap = std::unordered_map<std::string, std::string>;
+        using TreeMap = std::map<std::string, std::string>;
+        auto load_factor = [](float lf) {
+            return [lf](HashMap& m, uint64_t) { m.max_load_factor(lf); };
+        };
+        auto want = [&](const std::string& name) {
+            return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+        };
+
+        std::vector<Row> rows;
+        for (size_t ks : opt.key_sizes) {
+            std::vector<std::string> keys;
+            keys.reserve(opt.max_keys);
+            for (uint64_t i = 0; i < opt.max_keys; ++i) keys.push_back(make_key(i, ks));
+
+            for (size_t vs : opt.value_sizes) {
+                std::mt19937_64 rng(42); // Same lookup order for every size
+                for (uint64_t n = opt.min_keys; n <= opt.max_keys; n *= 10) {
+                    // Lookup order is drawn up front so the RNG is not timed
+                    KeyChooser chooser(opt.dist, n, opt.theta);
+                    std::vector<uint32_t> order(opt.lookups);
+                    for (auto& idx : order) idx = static_cast<uint32_t>(chooser.next(rng));
+
+                    if (want("unordered_map/lf0.5"))
+                        rows.push_back(run_container<HashMap>("unordered_map/lf0.5", ks, vs, n, keys, order, perf,
+                                                              load_factor(0.5f)));
+                    if (want("unordered_map/lf1.0"))
+                        rows.push_back(run_container<HashMap>("unordered_map/lf1.0", ks, vs, n, keys, order, perf,
+                                                              load_factor(1.0f)));
+                    if (want("unordered_map/lf2.0"))
+                        rows.push_back(run_container<HashMap>("unordered_map/lf2.0", ks, vs, n, keys, order, perf,
+                                                              load_factor(2.0f)));
+                    if (want("unordered_map/reserved"))
+                        rows.push_back(run_container<HashMap>("unordered_map/reserved", ks, vs, n, keys, order, perf,
+                                                              [](HashMap& m, uint64_t count) { m.reserve(count); }));
+                    if (want("map"))
+                        rows.push_back(run_container<TreeMap>("map", ks, vs, n, keys, order, perf,
+                                                              [](TreeMap&, uint64_t) {}));
+
+                    if (n > UINT64_MAX / 10) break;
+                }
+            }
+        }
+        print_rows(rows, opt, perf.available());
+    } catch (const std::exception& e) {
+        std::cerr << "ds_bench: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal JSON reader for the benchmark tools' own --json output and the
+// stored performance baseline. Supports the full grammar except \u
+// escapes beyond ASCII, which none of our producers emit.
+class JsonValue {
+public:
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    static JsonValue parse(const std::string& text) {
+        size_t pos = 0;
+        JsonValue v = parse_value(text, pos);
+        skip_ws(text, pos);
+        if (pos != text.size()) throw std::runtime_error("trailing data after JSON value");
+        return v;
+    }
+
+    Type type() const { return type_; }
+    bool is_null() const { return type_ == NUL; }
+    double number() const { expect(NUMBER); return number_; }
+    bool boolean() const { expect(BOOL); return bool_; }
+    const std::string& str() const { expect(STRING); return string_; }
+    const std::vector<JsonValue>& array() const { expect(ARRAY); return array_; }
+    const std::map<std::string, JsonValue>& object() const { expect(OBJECT); return object_; }
+
+    bool has(const std::string& key) const { return type_ == OBJECT && object_.count(key) > 0; }
+
+    const JsonValue& operator[](const std::string& key) const {
+        expect(OBJECT);
+        auto it = object_.find(key);
+        if (it == object_.end()) throw std::runtime_error("missing JSON key: " + key);
+        return it->second;
+    }
+
+private:
+    Type type_ = NUL;
+    bool bool_ = false;
+    double number_ = 0;
+    std::string string_;
+    std::vector<JsonValue> array_;
+    std::map<std::string, JsonValue> object_;
+
+    void expect(Type t) const {
+        if (type_ != t) throw std::runtime_error("unexpected JSON value type");
+    }
+
+    static void skip_ws(const std::string& s, size_t& pos) {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r')) ++pos;
+    }
+
+    static bool consume(const std::string& s, size_t& pos, const char* word) {
+        size_t len = std::char_traits<char>::length(word);
+        if (s.compare(pos, len, word) != 0) return false;
+        pos += len;
+        return true;
+    }
+
+    static std::string parse_string(const std::string& s, size_t& pos) {
+        std::string out;
+        ++pos; // Opening quote
+        while (pos < s.size() && s[pos] != '"') {
+            char c = s[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) break;
+            char e = s[pos++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u':
+                    if (pos + 4 > s.size()) throw std::runtime_error("bad JSON escape");
+                    out += static_cast<char>(std::strtol(s.substr(pos, 4).c_str(), nullptr, 16));
+                    pos += 4;
+                    break;
+                default: out += e; break; // \" \\ \/
+            }
+        }
+        if (pos >= s.size()) throw std::runtime_error("unterminated JSON string");
+        ++pos; // Closing quote
+        return out;
+    }
+
+    static JsonValue parse_value(const std::string& s, size_t& pos) {
+        skip_ws(s, pos);
+        if (pos >= s.size()) throw std::runtime_error("unexpected end of JSON");
+        JsonValue v;
+        char c = s[pos];
+        if (c == '{') {
+            v.type_ = OBJECT;
+            ++pos;
+            skip_ws(s, pos);
+            if (pos < s.size() && s[pos] == '}') { ++pos; return v; }
+            while (true) {
+                skip_ws(s, pos);
+                if (pos >= s.size() || s[pos] != '"') throw std::runtime_error("expected JSON object key");
+                std::string key = parse_string(s, pos);
+                skip_ws(s, pos);
+                if (pos >= s.size() || s[pos++] != ':') throw std::runtime_error("expected ':' in JSON object");
+                v.object_[key] = parse_value(s, pos);
+                skip_ws(s, pos);
+                if (pos < s.size() && s[pos] == ',') { ++pos; continue; }
+                if (pos < s.size() && s[pos] == '}') { ++pos; return v; }
+                throw std::runtime_error("expected ',' or '}' in JSON object");
+            }
+        }
+        if (c == '[') {
+            v.type_ = ARRAY;
+            ++pos;
+            skip_ws(s, pos);
+            if (pos < s.size() && s[pos] == ']') { ++pos; return v; }
+            while (true) {
+                v.array_.push_back(parse_value(s, pos));
+                skip_ws(s, pos);
+                if (pos < s.size() && s[pos] == ',') { ++pos; continue; }
+                if (pos < s.size() && s[pos] == ']') { ++pos; return v; }
+                throw std::runtime_error("expected ',' or ']' in JSON array");
+            }
+        }
+        if (c == '"') {
+            v.type_ = STRING;
+            v.string_ = parse_string(s, pos);
+            return v;
+        }
+        if (consume(s, pos, "true")) { v.type_ = BOOL; v.bool_ = true; return v; }
+        if (consume(s, pos, "false")) { v.type_ = BOOL; return v; }
+        if (consume(s, pos, "null")) return v;
+
+        char* end = nullptr;
+        v.number_ = std::strtod(s.c_str() + pos, &end);
+        if (end == s.c_str() + pos) throw std::runtime_error("invalid JSON value");
+        v.type_ = NUMBER;
+        pos = static_cast<size_t>(end - s.c_str());
+        return v;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+// Key choosers shared by the benchmark tools. Each picks an index in
+// [0, items) and is used from a single thread.
+
+// Every key equally likely
+class UniformChooser {
+    std::uniform_int_distribution<uint64_t> dist_;
+
+public:
+    explicit UniformChooser(uint64_t items) : dist_(0, items - 1) {}
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) { return dist_(rng); }
+};
+
+// Zipfian over [0, items), item 0 most popular, using the rejection-free
+// method of Gray et al. ("Quickly Generating Billion-Record Synthetic
+// Databases") as in YCSB. Setup is O(items) for the zeta constant.
+class ZipfianChooser {
+    uint64_t items_;
+    double theta_, alpha_, zetan_, eta_, half_pow_theta_;
+    std::uniform_real_distribution<double> unit_{0.0, 1.0};
+
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+        for (uint64_t i = 1; i <= n; ++i) sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        return sum;
+    }
+
+public:
+    static constexpr double DEFAULT_THETA = 0.99;
+
+    explicit ZipfianChooser(uint64_t items, double theta = DEFAULT_THETA)
+        : items_(items), theta_(theta) {
+        if (items == 0) throw std::invalid_argument("ZipfianChooser needs at least one item");
+        // alpha is 1/(1-theta): theta=1 divides by zero and theta>1 flips the sign
+        if (!(theta > 0 && theta < 1)) throw std::invalid_argument("zipfian theta must be in (0, 1)");
+        zetan_ = zeta(items, theta);
+        alpha_ = 1.0 / (1.0 - theta);
+        half_pow_theta_ = 1 + std::pow(0.5, theta);
+        update_eta();
+    }
+
+    uint64_t items() const { return items_; }
+
+    // Extends the range to [0, items). Only the new terms of zeta are
+    // summed, so growing one item at a time stays cheap.
+    void grow(uint64_t items) {
+        if (items <= items_) return;
+        for (uint64_t i = items_ + 1; i <= items; ++i) zetan_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+        items_ = items;
+        update_eta();
+    }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) {
+        if (items_ == 1) return 0;
+        double u = unit_(rng);
+        double uz = u * zetan_;
+        if (uz < 1.0) return 0;
+        if (uz < half_pow_theta_) return 1 % items_;
+        auto v = static_cast<uint64_t>(static_cast<double>(items_) * std::pow(eta_ * u - eta_ + 1, alpha_));
+        return v < items_ ? v : items_ - 1;
+    }
+
+private:
+    void update_eta() {
+        eta_ = (1 - std::pow(2.0 / static_cast<double>(items_), 1 - theta_)) / (1 - zeta(2, theta_) / zetan_);
+    }
+};
+
+// Zipfian whose popular items are spread over the key space instead of
+// clustered at the low indexes (YCSB "scrambled zipfian")
+class ScrambledZipfianChooser {
+    ZipfianChooser zipf_;
+    uint64_t items_;
+
+public:
+    explicit ScrambledZipfianChooser(uint64_t items, double theta = ZipfianChooser::DEFAULT_THETA)
+        : zipf_(items, theta), items_(items) {}
+
+    static uint64_t fnv1a(uint64_t value) {
+        uint64_t hash = 14695981039346656037ull;
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) { return fnv1a(zipf_.next(rng)) % items_; }
+};
+
+// Zipfian over recency: the most recently inserted item is the most
+// popular (YCSB "latest", workload D). The caller reports each insert
+// through grow(); next() returns an index in [0, items).
+class LatestChooser {
+    ZipfianChooser zipf_;
+
+public:
+    explicit LatestChooser(uint64_t items, double theta = ZipfianChooser::DEFAULT_THETA)
+        : zipf_(items, theta) {}
+
+    void grow(uint64_t items) { zipf_.grow(items); }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) { return zipf_.items() - 1 - zipf_.next(rng); }
+};
+
+// Runtime choice between the distributions above
+class KeyChooser {
+public:
+    enum Kind { UNIFORM, ZIPFIAN };
+
+    KeyChooser(Kind kind, uint64_t items, double theta = ZipfianChooser::DEFAULT_THETA)
+        : kind_(kind), uniform_(items), zipf_(kind == ZIPFIAN ? items : 1, theta) {}
+
+    static Kind parse_kind(const std::string& name) {
+        if (name == "uniform") return UNIFORM;
+        if (name == "zipf" || name == "zipfian") return ZIPFIAN;
+        throw std::invalid_argument("unknown key distribution: " + name);
+    }
+
+    template <typename Rng>
+    uint64_t next(Rng& rng) { return kind_ == UNIFORM ? uniform_.next(rng) : zipf_.next(rng); }
+
+private:
+    Kind kind_;
+    UniformChooser uniform_;
+    ScrambledZipfianChooser zipf_;
+};
@@ -0,0 +1,253 @@
+// micro_bench.cpp
+// Microbenchmarks for HttpReader and HttpMessage::parse.
+//
+// Every iteration writes one input into a pipe and times only the parser
+// reading it back, so the numbers cover the read() syscalls and the
+// parsing work but not the producer. Allocations are counted by replacing
+// the global operator new for this binary.
+//
+// Built-in corpora cover small GETs, many headers, large bodies and
+// chunked streams. Recorded requests can be added with --corpus FILE: each
+// file holds the raw bytes of one HTTP request.
+#include "../src/utils/http_message.hpp"
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// --- Allocation counting ---
+namespace {
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_alloc_bytes{0};
+}
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0;
+    double bytes_per_sec = 0;
+    double allocs_per_op = 0;
+    double alloc_bytes_per_op = 0;
+};
+
+// A pipe big enough to hold one whole input
+class Pipe {
+    int fds_[2] = {-1, -1};
+
+public:
+    explicit Pipe(size_t capacity) {
+        if (pipe(fds_) < 0) throw std::runtime_error("pipe failed");
+        if (capacity > 64 * 1024 && fcntl(fds_[1], F_SETPIPE_SZ, static_cast<int>(capacity)) < 0) {
+            throw std::runtime_error("cannot grow pipe to " + std::to_string(capacity) +
+                                     " bytes (see /proc/sys/fs/pipe-max-size)");
+        }
+    }
+    ~Pipe() { close(fds_[0]); close(fds_[1]); }
+
+    int read_fd() const { return fds_[0]; }
+
+    void write_all(const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = write(fds_[1], data.data() + done, data.size() - done);
+            if (n <= 0) throw std::runtime_error("pipe write failed");
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    Pipe(const Pipe&) = delete;
+    Pipe& operator=(const Pipe&) = delete;
+};
+
+// Runs `op` on `input` for `iterations` rounds after a short warm-up
+Result run(const std::string& name, const std::string& input, uint64_t iterations,
+           const std::function<void(int fd)>& op) {
+    Pipe pipe(input.size() + 4096);
+    for (int i = 0; i < 16; ++i) {
+        pipe.write_all(input);
+        op(pipe.read_fd());
+    }
+
+    uint64_t total_ns = 0;
+    uint64_t allocs = 0, alloc_bytes = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        pipe.write_all(input);
+        uint64_t a0 = g_allocs.load(std::memory_order_relaxed);
+        uint64_t b0 = g_alloc_bytes.load(std::memory_order_relaxed);
+        auto t0 = std::chrono::steady_clock::now();
+        op(pipe.read_fd());
+        auto t1 = std::chrono::steady_clock::now();
+        allocs += g_allocs.load(std::memory_order_relaxed) - a0;
+        alloc_bytes += g_alloc_bytes.load(std::memory_order_relaxed) - b0;
+        total_ns += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+    }
+
+    Result r;
+    r.name = name;
+    r.iterations = iterations;
+    r.ns_per_op = static_cast<double>(total_ns) / iterations;
+    r.bytes_per_sec = total_ns ? input.size() * iterations * 1e9 / total_ns : 0;
+    r.allocs_per_op = static_cast<double>(allocs) / iterations;
+    r.alloc_bytes_per_op = static_cast<double>(alloc_bytes) / iterations;
+    return r;
+}
+
+// --- Built-in corpora ---
+
+std::string small_get() {
+    return "GET /index.html HTTP/1.1\r\nHost: localhost:8080\r\nUser-Agent: curl/8.0\r\nAccept: */*\r\n\r\n";
+}
+
+std::string many_headers(int count) {
+    std::string req = "GET /api/v1/items?id=42 HTTP/1.1\r\nHost: localhost:8080\r\n";
+    for (int i = 0; i < count; ++i) {
+        req += "X-Custom-Header-" + std::to_string(i) + ": value-" + std::to_string(i) +
+               "-abcdefghijklmnopqrstuvwxyz\r\n";
+    }
+    return req + "\r\n";
+}
+
+std::string with_body(size_t size) {
+    return "POST /upload HTTP/1.1\r\nHost: localhost:8080\r\nContent-Type: application/octet-stream\r\n"
+           "Content-Length: " + std::to_string(size) + "\r\n\r\n" + std::string(size, 'b');
+}
+
+std::string chunk_stream(size_t chunk_size, int chunks) {
+    std::ostringstream s;
+    for (int i = 0; i < chunks; ++i) {
+        s << std::hex << chunk_size << "\r\n" << std::string(chunk_size, 'c') << "\r\n";
+    }
+    s << "0\r\n\r\n";
+    return s.str();
+}
+
+std::string chunked_request(size_t chunk_size, int chunks) {
+    return "POST /stream HTTP/1.1\r\nHost: localhost:8080\r\nTransfer-Encoding: chunked\r\n\r\n" +
+           chunk_stream(chunk_size, chunks);
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("cannot open corpus file " + path);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void print_table(const std::vector<Result>& results) {
+    std::printf("%-36s %10s %12s %12s %10s %12s\n",
+                "benchmark", "iters", "ns/op", "MB/s", "allocs/op", "alloc B/op");
+    for (const auto& r : results) {
+        std::printf("%-36s %10llu %12.1f %12.1f %10.2f %12.1f\n", r.name.c_str(),
+                    static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.bytes_per_sec / 1e6,
+                    r.allocs_per_op, r.alloc_bytes_per_op);
+    }
+}
+
+void print_json(const std::vector<Result>& results) {
+    std::printf("{\"suite\":\"micro_bench\",\"benchmarks\":[");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        std::printf("%s{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,\"bytes_per_sec\":%.1f,"
+                    "\"allocs_per_op\":%.3f,\"alloc_bytes_per_op\":%.1f}",
+                    i ? "," : "", r.name.c_str(), static_cast<unsigned long long>(r.iterations),
+                    r.ns_per_op, r.bytes_per_sec, r.allocs_per_op, r.alloc_bytes_per_op);
+    }
+    std::printf("]}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint64_t iterations = 20000;
+    std::string filter;
+    bool json = false;
+    std::vector<std::string> corpus_files;
+
+    enum { ITERATIONS = 1, FILTER, CORPUS, JSON, HELP };
+    static const option long_options[] = {
+        {"iterations", required_argument, nullptr, ITERATIONS},
+        {"filter", required_argument, nullptr, FILTER},
+        {"corpus", required_argument, nullptr, CORPUS},
+        {"json", no_argument, nullptr, JSON},
+        {"help", no_argument, nullptr, HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        switch (c) {
+            case ITERATIONS: iterations = std::max<uint64_t>(1, std::stoull(optarg)); break;
+            case FILTER: filter = optarg; break;
+            case CORPUS: corpus_files.push_back(optarg); break;
+            case JSON: json = true; break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [--iterations N] [--filter SUBSTR] [--corpus FILE]... [--json]\n";
+                return c == HELP ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::vector<Result> results;
+        auto bench = [&](const std::string& name, const std::string& input, uint64_t iters,
+                         const std::function<void(int)>& op) {
+            if (!filter.empty() && name.find(filter) == std::string::npos) return;
+            results.push_back(run(name, input, std::max<uint64_t>(1, iters), op));
+        };
+        auto parse = [](int fd) { HttpMessage::parse(fd); };
+
+        // HttpMessage::parse end to end
+        bench("parse/small_get", small_get(), iterations, parse);
+        bench("parse/headers_64", many_headers(64), iterations, parse);
+        bench("parse/body_4k", with_body(4 * 1024), iterations, parse);
+        bench("parse/body_256k", with_body(256 * 1024), iterations / 20, parse);
+        bench("parse/chunked_64x1k", chunked_request(1024, 64), iterations / 10, parse);
+
+        // HttpReader primitives
+        std::string headers = many_headers(16);
+        bench("reader/read_until_headers", headers, iterations,
+              [](int fd) { HttpReader(fd).read_until("\r\n\r\n"); });
+        bench("reader/read_fixed_64k", std::string(64 * 1024, 'f'), iterations / 10,
+              [](int fd) { HttpReader(fd).read_fixed(64 * 1024); });
+        bench("reader/read_chunked_256x256", chunk_stream(256, 256), iterations / 10,
+              [](int fd) { HttpReader(fd).read_chunked(); });
+
+        // Recorded requests
+        for (const auto& path : corpus_files) {
+            std::string name = "corpus/" + path.substr(path.find_last_of('/') + 1);
+            bench(name, read_file(path), iterations, parse);
+        }
+
+        if (json) print_json(results);
+        else print_table(results);
+    } catch (const std::exception& e) {
+        std::cerr << "micro_bench: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
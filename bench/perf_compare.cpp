@@ -0,0 +1,390 @@
+// perf_compare.cpp
+// Performance regression check: runs the micro and macro benchmarks
+// several times, takes the median of every metric and compares it with a
+// stored baseline. Exits 1 on a significant regression, 2 on errors.
+//
+//   micro  micro_bench --json: ns/op and allocations/op per benchmark
+//   macro  a server started on port 8080, driven by bench_client (closed
+//          loop HTTP) and ycsb workload A: throughput and p99 latency
+//
+// A metric regresses when its median moves in the bad direction by more
+// than the larger of --threshold percent and --noise-k times the noise,
+// where noise is the scaled median absolute deviation of the current
+// runs or of the baseline, whichever is wider. A MAD over fewer than
+// MIN_RUNS samples says little about the noise, so such a side is assumed
+// to be FEW_RUNS_NOISE noisy instead. Allocation counts are deterministic
+// and use a tight fixed tolerance.
+//
+// The baseline is committed as bench/perf_baseline.json so every checkout
+// can compare against it. It is recorded with --update (the perf_baseline
+// target) from a Release build on a known good commit, with at least
+// MIN_RUNS runs. Numbers still depend on the machine: a different build
+// type only gets a warning, and -DPERF_BASELINE selects a local file.
+#include "json.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#ifndef PERF_BASELINE
+#define PERF_BASELINE "perf_baseline.json"
+#endif
+#ifndef PERF_BUILD_TYPE
+#define PERF_BUILD_TYPE ""
+#endif
+
+namespace {
+
+constexpr int SERVER_PORT = 8080; // Fixed in server.cpp
+constexpr double MAD_TO_SIGMA = 1.4826;
+constexpr double ALLOC_TOLERANCE = 0.01; // Allocations per op
+constexpr int MIN_RUNS = 5;              // Runs needed before a MAD is trusted
+constexpr double FEW_RUNS_NOISE = 0.10;  // Relative sigma assumed below MIN_RUNS
+
+struct Options {
+    std::string baseline = PERF_BASELINE;
+    std::string bin_dir;
+    int runs = 5;
+    double threshold_pct = 5;
+    double noise_k = 3;
+    uint64_t micro_iterations = 5000;
+    double macro_duration_s = 3;
+    bool skip_macro = false;
+    bool update = false;
+};
+
+struct Metric {
+    bool lower_is_better = true;
+    bool exact = false; // Deterministic count, compared with ALLOC_TOLERANCE
+    std::vector<double> samples;
+};
+
+using Metrics = std::map<std::string, Metric>;
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t mid = v.size() / 2;
+    return v.size() % 2 ? v[mid] : (v[mid - 1] + v[mid]) / 2;
+}
+
+double mad(const std::vector<double>& v) {
+    double m = median(v);
+    std::vector<double> dev;
+    for (double x : v) dev.push_back(std::fabs(x - m));
+    return median(dev);
+}
+
+// Runs a program and returns its stdout; throws if it fails
+std::string run_capture(const std::string& path, const std::vector<std::string>& args) {
+    int fds[2];
+    if (pipe(fds) < 0) throw std::runtime_error("pipe failed");
+    pid_t pid = fork();
+    if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>(path.c_str()));
+        for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+        argv.push_back(nullptr);
+        execv(path.c_str(), argv.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0 || (n < 0 && errno == EINTR)) {
+        if (n > 0) out.append(buf, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw std::runtime_error(path + " failed");
+    return out;
+}
+
+bool port_open(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    close(fd);
+    return ok;
+}
+
+// The server under test, started for the macro benchmarks
+class ServerProcess {
+public:
+    explicit ServerProcess(const std::string& path) {
+        if (port_open(SERVER_PORT)) {
+            throw std::runtime_error("port " + std::to_string(SERVER_PORT) + " is already in use");
+        }
+        pid_ = fork();
+        if (pid_ < 0) throw std::runtime_error("fork failed");
+        if (pid_ == 0) {
+            int devnull = open("/dev/null", O_WRONLY);
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            setenv("DBG_LEVEL", "warn", 1);
+            execl(path.c_str(), path.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        for (int i = 0; i < 100 && !port_open(SERVER_PORT); ++i) {
+            if (waitpid(pid_, nullptr, WNOHANG) == pid_) {
+                pid_ = -1;
+                throw std::runtime_error("server exited during startup");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (!port_open(SERVER_PORT)) throw std::runtime_error("server did not start listening");
+    }
+
+    ~ServerProcess() {
+        if (pid_ <= 0) return;
+        kill(pid_, SIGINT);
+        for (int i = 0; i < 100; ++i) {
+            if (waitpid(pid_, nullptr, WNOHANG) == pid_) return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        kill(pid_, SIGKILL);
+        waitpid(pid_, nullptr, 0);
+    }
+
+    ServerProcess(const ServerProcess&) = delete;
+    ServerProcess& operator=(const ServerProcess&) = delete;
+
+private:
+    pid_t pid_ = -1;
+};
+
+void add_sample(Metrics& metrics, const std::string& name, double value, bool lower_is_better, bool exact = false) {
+    Metric& m = metrics[name];
+    m.lower_is_better = lower_is_better;
+    m.exact = exact;
+    m.samples.push_back(value);
+}
+
+void run_micro(const Options& opt, Metrics& metrics) {
+    JsonValue doc = JsonValue::parse(run_capture(opt.bin_dir + "/micro_bench",
+        {"--json", "--iterations", std::to_string(opt.micro_iterations)}));
+    for (const auto& b : doc["benchmarks"].array()) {
+        std::string name = "micro/" + b["name"].str();
+        add_sample(metrics, name + "/ns_per_op", b["ns_per_op"].number(), true);
+        add_sample(metrics, name + "/allocs_per_op", b["allocs_per_op"].number(), true, true);
+    }
+}
+
+void run_macro(const Options& opt, Metrics& metrics) {
+    JsonValue load = JsonValue::parse(run_capture(opt.bin_dir + "/bench_client",
+        {"--json", "--connections", "16", "--threads", "2", "--duration", std::to_string(opt.macro_duration_s)}));
+    add_sample(metrics, "macro/bench_client/throughput_rps", load["throughput_rps"].number(), false);
+    add_sample(metrics, "macro/bench_client/p99_us", load["latency_us"]["p99"].number(), true);
+
+    JsonValue ycsb = JsonValue::parse(run_capture(opt.bin_dir + "/ycsb",
+        {"--json", "--workload", "a", "--threads", "4", "--records", "2000", "--operations", "20000"}));
+    for (const auto& phase : ycsb["phases"].array()) {
+        if (phase["phase"].str() != "RUN") continue;
+        add_sample(metrics, "macro/ycsb_a/throughput_ops", phase["throughput_ops"].number(), false);
+        for (const auto& [op, stats] : phase["ops"].object()) {
+            add_sample(metrics, "macro/ycsb_a/" + op + "/p99_us", stats["latency_us"]["p99"].number(), true);
+        }
+    }
+}
+
+void write_baseline(const Options& opt, const Metrics& metrics) {
+    FILE* f = std::fopen(opt.baseline.c_str(), "w");
+    if (!f) throw std::runtime_error("cannot write " + opt.baseline);
+    std::fprintf(f, "{\n  \"version\": 1,\n  \"runs\": %d,\n  \"build_type\": \"%s\",\n  \"metrics\": {\n",
+                 opt.runs, PERF_BUILD_TYPE);
+    size_t i = 0;
+    for (const auto& [name, m] : metrics) {
+        std::fprintf(f, "    \"%s\": {\"median\": %.4f, \"mad\": %.4f, \"better\": \"%s\", \"exact\": %s}%s\n",
+                     name.c_str(), median(m.samples), mad(m.samples), m.lower_is_better ? "lower" : "higher",
+                     m.exact ? "true" : "false", ++i < metrics.size() ? "," : "");
+    }
+    std::fprintf(f, "  }\n}\n");
+    std::fclose(f);
+    std::printf("wrote %zu metrics to %s\n", metrics.size(), opt.baseline.c_str());
+}
+
+JsonValue read_baseline(const Options& opt) {
+    std::FILE* f = std::fopen(opt.baseline.c_str(), "r");
+    if (!f) {
+        throw std::runtime_error("cannot read baseline " + opt.baseline +
+                                 " (record one with --update, or build the perf_baseline target)");
+    }
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    std::fclose(f);
+    return JsonValue::parse(text);
+}
+
+// Prints the comparison and returns the number of regressions
+int compare(const Options& opt, const JsonValue& doc, const Metrics& metrics) {
+    const auto& base = doc["metrics"].object();
+    int base_runs = static_cast<int>(doc["runs"].number());
+    std::string base_build = doc.has("build_type") ? doc["build_type"].str() : "";
+    if (base_build != PERF_BUILD_TYPE) {
+        std::printf("warning: baseline is from a %s build, this is a %s build\n",
+                    base_build.empty() ? "default" : base_build.c_str(),
+                    *PERF_BUILD_TYPE ? PERF_BUILD_TYPE : "default");
+    }
+
+    int regressions = 0;
+    std::printf("%-52s %12s %12s %9s %9s  %s\n", "metric", "baseline", "current", "change", "allowed", "status");
+    for (const auto& [name, m] : metrics) {
+        double cur = median(m.samples);
+        auto it = base.find(name);
+        if (it == base.end()) {
+            std::printf("%-52s %12s %12.2f %9s %9s  new\n", name.c_str(), "-", cur, "-", "-");
+            continue;
+        }
+        double ref = it->second["median"].number();
+        double ref_mad = it->second["mad"].number();
+
+        // Positive change means worse
+        double worse = m.lower_is_better ? cur - ref : ref - cur;
+        double change = ref != 0 ? worse / std::fabs(ref) : 0;
+        bool regressed;
+        double allowed;
+        if (m.exact) {
+            allowed = ref != 0 ? ALLOC_TOLERANCE / std::fabs(ref) : 0;
+            regressed = worse > ALLOC_TOLERANCE;
+        } else {
+            double noise = 0;
+            if (opt.runs < MIN_RUNS) noise = FEW_RUNS_NOISE;
+            else if (cur != 0) noise = MAD_TO_SIGMA * mad(m.samples) / std::fabs(cur);
+            if (base_runs < MIN_RUNS) noise = std::max(noise, FEW_RUNS_NOISE);
+            else if (ref != 0) noise = std::max(noise, MAD_TO_SIGMA * ref_mad / std::fabs(ref));
+            allowed = std::max(opt.threshold_pct / 100, opt.noise_k * noise);
+            regressed = ref != 0 ? change > allowed : worse > 0;
+        }
+        if (regressed) ++regressions;
+        std::printf("%-52s %12.2f %12.2f %8.1f%% %8.1f%%  %s\n", name.c_str(), ref, cur, change * 100,
+                    allowed * 100, regressed ? "REGRESSION" : change < -allowed ? "improved" : "ok");
+    }
+    for (const auto& [name, value] : base) {
+        if (!metrics.count(name)) std::printf("%-52s %12.2f %12s %9s %9s  missing\n", name.c_str(),
+                                              value["median"].number(), "-", "-", "-");
+    }
+    return regressions;
+}
+
+void usage(const char* prog) {
+    std::cerr <<
+        "Usage: " << prog << " [options]\n"
+        "  --baseline FILE        baseline JSON (default " PERF_BASELINE ")\n"
+        "  --bin-dir DIR          directory with the benchmark binaries (default: next to this one)\n"
+        "  --runs N               repetitions per benchmark (default 5, at least 5 with --update)\n"
+        "  --threshold PCT        minimum relative change reported as a regression (default 5)\n"
+        "  --noise-k K            noise multiplier for the threshold (default 3)\n"
+        "  --micro-iterations N   micro_bench --iterations (default 5000)\n"
+        "  --macro-duration S     bench_client run time in seconds (default 3)\n"
+        "  --skip-macro           only run the micro benchmarks\n"
+        "  --update               write the medians as the new baseline instead of comparing\n";
+}
+
+Options parse_args(int argc, char** argv) {
+    enum { BASELINE = 1, BIN_DIR, RUNS, THRESHOLD, NOISE_K, MICRO_ITERATIONS, MACRO_DURATION, SKIP_MACRO,
+           UPDATE, HELP };
+    static const option long_options[] = {
+        {"baseline", required_argument, nullptr, BASELINE},
+        {"bin-dir", required_argument, nullptr, BIN_DIR},
+        {"runs", required_argument, nullptr, RUNS},
+        {"threshold", required_argument, nullptr, THRESHOLD},
+        {"noise-k", required_argument, nullptr, NOISE_K},
+        {"micro-iterations", required_argument, nullptr, MICRO_ITERATIONS},
+        {"macro-duration", required_argument, nullptr, MACRO_DURATION},
+        {"skip-macro", no_argument, nullptr, SKIP_MACRO},
+        {"update", no_argument, nullptr, UPDATE},
+        {"help", no_argument, nullptr, HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+    Options opt;
+    std::string self = argv[0];
+    opt.bin_dir = self.find('/') == std::string::npos ? "." : self.substr(0, self.find_last_of('/'));
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        std::string arg = optarg ? optarg : "";
+        switch (c) {
+            case BASELINE: opt.baseline = arg; break;
+            case BIN_DIR: opt.bin_dir = arg; break;
+            case RUNS: opt.runs = std::stoi(arg); break;
+            case THRESHOLD: opt.threshold_pct = std::stod(arg); break;
+            case NOISE_K: opt.noise_k = std::stod(arg); break;
+            case MICRO_ITERATIONS: opt.micro_iterations = std::stoull(arg); break;
+            case MACRO_DURATION: opt.macro_duration_s = std::stod(arg); break;
+            case SKIP_MACRO: opt.skip_macro = true; break;
+            case UPDATE: opt.update = true; break;
+            case HELP: usage(argv[0]); std::exit(EXIT_SUCCESS);
+            default: usage(argv[0]); std::exit(2);
+        }
+    }
+    if (opt.runs < 1) throw std::invalid_argument("--runs must be at least 1");
+    if (opt.update && opt.runs < MIN_RUNS) {
+        throw std::invalid_argument("--update needs --runs " + std::to_string(MIN_RUNS) + " or more");
+    }
+    return opt;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+        signal(SIGPIPE, SIG_IGN);
+        JsonValue baseline;
+        if (!opt.update) baseline = read_baseline(opt); // Fail before spending minutes on benchmarks
+
+        Metrics metrics;
+        for (int r = 0; r < opt.runs; ++r) {
+            std::fprintf(stderr, "perf_compare: micro run %d/%d\n", r + 1, opt.runs);
+            run_micro(opt, metrics);
+        }
+        if (!opt.skip_macro) {
+            ServerProcess server(opt.bin_dir + "/server");
+            for (int r = 0; r < opt.runs; ++r) {
+                std::fprintf(stderr, "perf_compare: macro run %d/%d\n", r + 1, opt.runs);
+                run_macro(opt, metrics);
+            }
+        }
+
+        if (opt.update) {
+            write_baseline(opt, metrics);
+            return EXIT_SUCCESS;
+        }
+        int regressions = compare(opt, baseline, metrics);
+        if (regressions) {
+            std::printf("%d regression(s) against %s\n", regressions, opt.baseline.c_str());
+            return EXIT_FAILURE;
+        }
+        std::printf("no regressions against %s\n", opt.baseline.c_str());
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "perf_compare: " << e.what() << std::endl;
+        return 2;
+    }
+}
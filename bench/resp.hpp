@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+// RESP framing helpers shared by the benchmark tools
+
+// Length of the first complete RESP reply in [p, p+n), or 0 if incomplete
+inline size_t resp_reply_length(const char* p, size_t n) {
+    const char* end = static_cast<const char*>(memmem(p, n, "\r\n", 2));
+    if (!end) return 0;
+    size_t line = end - p + 2;
+    switch (p[0]) {
+        case '+': case '-': case ':': case '_': case ',': case '#':
+            return line;
+        case '$': {
+            long len = std::strtol(p + 1, nullptr, 10);
+            if (len < 0) return line; // Null bulk string
+            size_t total = line + static_cast<size_t>(len) + 2;
+            return n >= total ? total : 0;
+        }
+        case '*': {
+            long count = std::strtol(p + 1, nullptr, 10);
+            size_t total = line;
+            for (long i = 0; i < count; ++i) {
+                size_t elem = resp_reply_length(p + total, n - total);
+                if (elem == 0) return 0;
+                total += elem;
+            }
+            return total;
+        }
+        default:
+            return line; // Unknown type: skip the line
+    }
+}
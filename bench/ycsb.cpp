@@ -0,0 +1,597 @@
+// ycsb.cpp
+// YCSB-style workload driver: runs the core workloads A-F against the
+// server with the same operation mixes and key distributions as YCSB's
+// CoreWorkload, so results can be compared with other stores.
+//
+//   A  update heavy     read 50%, update 50%           zipfian
+//   B  read mostly      read 95%, update 5%            zipfian
+//   C  read only        read 100%                      zipfian
+//   D  read latest      read 95%, insert 5%            latest
+//   E  short ranges     scan 95%, insert 5%            zipfian, scans of 1-100
+//   F  read-modify-wr.  read 50%, read-modify-write 50% zipfian
+//
+// The load phase inserts --records keys, then the run phase issues
+// --operations requests. Each thread is one blocking client, as in YCSB,
+// so throughput is closed loop and scales with --threads.
+//
+// Operations map to HTTP as GET /key (read), POST /key (insert, update)
+// and GET /key?scan=N (scan), and to RESP as GET, SET and MGET of N
+// consecutive records. Read-modify-write is a read followed by an update
+// and is timed as one operation.
+#include "../src/stats/histogram.hpp"
+#include "key_chooser.hpp"
+#include "resp.hpp"
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum Op { READ, UPDATE, INSERT, SCAN, READ_MODIFY_WRITE, OP_COUNT };
+
+const char* op_name(Op op) {
+    switch (op) {
+        case READ: return "READ";
+        case UPDATE: return "UPDATE";
+        case INSERT: return "INSERT";
+        case SCAN: return "SCAN";
+        case READ_MODIFY_WRITE: return "READ-MODIFY-WRITE";
+        default: return "UNKNOWN";
+    }
+}
+
+enum Distribution { DIST_UNIFORM, DIST_ZIPFIAN, DIST_LATEST };
+
+const char* dist_name(Distribution d) {
+    switch (d) {
+        case DIST_UNIFORM: return "uniform";
+        case DIST_ZIPFIAN: return "zipfian";
+        case DIST_LATEST: return "latest";
+        default: return "unknown";
+    }
+}
+
+struct Workload {
+    char name;
+    double proportion[OP_COUNT]; // Indexed by Op
+    Distribution dist;
+};
+
+// Core workload definitions, as in YCSB's workloads/workload[a-f]
+const Workload WORKLOADS[] = {
+    {'a', {0.50, 0.50, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+    {'b', {0.95, 0.05, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+    {'c', {1.00, 0.00, 0.00, 0.00, 0.00}, DIST_ZIPFIAN},
+    {'d', {0.95, 0.00, 0.05, 0.00, 0.00}, DIST_LATEST},
+    {'e', {0.00, 0.00, 0.05, 0.95, 0.00}, DIST_ZIPFIAN},
+    {'f', {0.50, 0.00, 0.00, 0.00, 0.50}, DIST_ZIPFIAN},
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    bool resp = false;
+    Workload workload = WORKLOADS[0];
+    bool load = true;
+    bool run = true;
+    uint64_t records = 100000;
+    uint64_t operations = 100000;
+    int threads = 8;
+    size_t value_size = 1000; // YCSB default record: 10 fields of 100 bytes
+    uint64_t max_scan = 100;
+    double theta = ZipfianChooser::DEFAULT_THETA;
+    std::string key_prefix = "user";
+    bool hashed_keys = true;
+    bool json = false;
+};
+
+uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void usage(const char* prog) {
+    std::cerr <<
+        "Usage: " << prog << " [options]\n"
+        "  --workload a|b|c|d|e|f     core workload (default a)\n"
+        "  --phase load|run|both      phases to execute (default both)\n"
+        "  --records N                records inserted by the load phase (default 100000)\n"
+        "  --operations N             operations in the run phase (default 100000)\n"
+        "  --threads N                client threads (default 8)\n"
+        "  --dist uniform|zipfian|latest  override the workload's request distribution\n"
+        "  --theta T                  zipfian skew, 0 < T < 1 (default 0.99)\n"
+        "  --value-size N             record size in bytes (default 1000)\n"
+        "  --max-scan N               longest scan for workload E (default 100)\n"
+        "  --key-prefix P             key prefix (default \"user\")\n"
+        "  --ordered-keys             use key numbers directly instead of hashing them\n"
+        "  --host HOST                server address (default 127.0.0.1)\n"
+        "  --port PORT                server port (default 8080)\n"
+        "  --protocol http|resp       wire protocol (default http)\n"
+        "  --json                     print the results as JSON\n";
+}
+
+Options parse_args(int argc, char** argv) {
+    enum { WORKLOAD = 1, PHASE, RECORDS, OPERATIONS, THREADS, DIST, THETA, VALUE_SIZE, MAX_SCAN,
+           KEY_PREFIX, ORDERED_KEYS, HOST, PORT, PROTOCOL, JSON, HELP };
+    static const option long_options[] = {
+        {"workload", required_argument, nullptr, WORKLOAD},
+        {"phase", required_argument, nullptr, PHASE},
+        {"records", required_argument, nullptr, RECORDS},
+        {"operations", required_argument, nullptr, OPERATIONS},
+        {"threads", required_argument, nullptr, THREADS},
+        {"dist", required_argument, nullptr, DIST},
+        {"theta", required_argument, nullptr, THETA},
+        {"value-size", required_argument, nullptr, VALUE_SIZE},
+        {"max-scan", required_argument, nullptr, MAX_SCAN},
+        {"key-prefix", required_argument, nullptr, KEY_PREFIX},
+        {"ordered-keys", no_argument, nullptr, ORDERED_KEYS},
+        {"host", required_argument, nullptr, HOST},
+        {"port", required_argument, nullptr, PORT},
+        {"protocol", required_argument, nullptr, PROTOCOL},
+        {"json", no_argument, nullptr, JSON},
+        {"help", no_argument, nullptr, HELP},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    Options opt;
+    int dist_override = -1;
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        std::string arg = optarg ? optarg : "";
+        switch (c) {
+            case WORKLOAD: {
+                auto it = std::find_if(std::begin(WORKLOADS), std::end(WORKLOADS), [&](const Workload& w) {
+                    return arg.size() == 1 && std::tolower(static_cast<unsigned char>(arg[0])) == w.name;
+                });
+                if (it == std::end(WORKLOADS)) throw std::invalid_argument("unknown workload: " + arg);
+                opt.workload = *it;
+                break;
+            }
+            case PHASE:
+                if (arg == "load") opt.run = false;
+                else if (arg == "run") opt.load = false;
+                else if (arg != "both") throw std::invalid_argument("unknown phase: " + arg);
+                break;
+            case RECORDS: opt.records = std::stoull(arg); break;
+            case OPERATIONS: opt.operations = std::stoull(arg); break;
+            case THREADS: opt.threads = std::stoi(arg); break;
+            case DIST:
+                if (arg == "uniform") dist_override = DIST_UNIFORM;
+                else if (arg == "zipf" || arg == "zipfian") dist_override = DIST_ZIPFIAN;
+                else if (arg == "latest") dist_override = DIST_LATEST;
+                else throw std::invalid_argument("unknown key distribution: " + arg);
+                break;
+            case THETA: opt.theta = std::stod(arg); break;
+            case VALUE_SIZE: opt.value_size = std::stoul(arg); break;
+            case MAX_SCAN: opt.max_scan = std::stoull(arg); break;
+            case KEY_PREFIX: opt.key_prefix = arg; break;
+            case ORDERED_KEYS: opt.hashed_keys = false; break;
+            case HOST: opt.host = arg; break;
+            case PORT: opt.port = std::stoi(arg); break;
+            case PROTOCOL:
+                if (arg == "resp") opt.resp = true;
+                else if (arg != "http") throw std::invalid_argument("unknown protocol: " + arg);
+                break;
+            case JSON: opt.json = true; break;
+            case HELP: usage(argv[0]); std::exit(EXIT_SUCCESS);
+            default: usage(argv[0]); std::exit(EXIT_FAILURE);
+        }
+    }
+    if (dist_override >= 0) opt.workload.dist = static_cast<Distribution>(dist_override);
+    if (opt.records < 1 || opt.threads < 1 || opt.max_scan < 1) throw std::invalid_argument("invalid option value");
+    if (!(opt.theta > 0 && opt.theta < 1)) throw std::invalid_argument("--theta must be in (0, 1)");
+    return opt;
+}
+
+// One blocking client, as a YCSB client thread. HTTP reconnects for every
+// request because the server closes after each response; RESP keeps a
+// single connection open.
+class Client {
+public:
+    Client(const Options& opt, const sockaddr_in& addr) : opt_(opt), addr_(addr) {}
+    ~Client() { disconnect(); }
+
+    // Sends `request` and waits for one reply; false on any error
+    bool call(const std::string& request) {
+        if (fd_ < 0 && !connect_server()) return false;
+        bool ok;
+        try {
+            ok = send_all(request) && read_reply();
+        } catch (const std::logic_error&) {
+            ok = false; // Unparsable reply (e.g. Content-Length): an error for this operation only
+        }
+        if (!ok || !opt_.resp) disconnect();
+        return ok;
+    }
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+private:
+    const Options& opt_;
+    sockaddr_in addr_;
+    int fd_ = -1;
+    std::string in_;
+
+    bool connect_server() {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) return false;
+        int one = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd_, reinterpret_cast<const sockaddr*>(&addr_), sizeof(addr_)) < 0) {
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    void disconnect() {
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+        in_.clear();
+    }
+
+    bool send_all(const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = send(fd_, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Appends more input; false on EOF or error
+    bool fill() {
+        char buf[64 * 1024];
+        while (true) {
+            ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            in_.append(buf, static_cast<size_t>(n));
+            return true;
+        }
+    }
+
+    bool read_reply() {
+        if (opt_.resp) {
+            size_t len;
+            while ((len = resp_reply_length(in_.data(), in_.size())) == 0) {
+                if (!fill()) return false;
+            }
+            bool ok = in_[0] != '-';
+            in_.erase(0, len);
+            return ok;
+        }
+
+        // HTTP: headers, then Content-Length bytes or everything up to EOF
+        size_t header_end;
+        while ((header_end = in_.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) return false;
+        }
+        std::string head = in_.substr(0, header_end);
+        std::transform(head.begin(), head.end(), head.begin(), [](unsigned char ch) { return std::tolower(ch); });
+        size_t cl = head.find("\r\ncontent-length:");
+        if (cl != std::string::npos) {
+            size_t want = header_end + 4 + std::stoul(head.substr(cl + 17));
+            while (in_.size() < want) {
+                if (!fill()) return false;
+            }
+        } else {
+            while (fill()) {}
+        }
+        return in_.compare(0, 9, "HTTP/1.1 ") == 0 && in_.size() > 9 && in_[9] == '2';
+    }
+};
+
+struct OpStats {
+    stats::LogLinearHistogram latency;
+    uint64_t errors = 0;
+};
+
+struct PhaseResult {
+    const char* phase;
+    double runtime_s = 0;
+    stats::LogLinearHistogram::Snapshot latency[OP_COUNT];
+    uint64_t errors[OP_COUNT] = {};
+};
+
+// Skewed choosers for one phase. Building a zipfian sums zeta over every
+// record, so this is done once and each client thread copies the result.
+// Distributions the phase does not use are built over a single item.
+struct Choosers {
+    ScrambledZipfianChooser zipf;
+    LatestChooser latest;
+
+    Choosers(Distribution dist, uint64_t records, double theta)
+        : zipf(dist == DIST_ZIPFIAN ? records : 1, theta),
+          latest(dist == DIST_LATEST ? records : 1, theta) {}
+};
+
+// Shared between the client threads of one run
+struct KeySpace {
+    uint64_t records;
+    std::atomic<uint64_t> next_insert;   // Next key number to insert
+    std::atomic<uint64_t> acknowledged;  // Keys [0, acknowledged) are known to exist
+};
+
+class Runner {
+public:
+    Runner(const Options& opt, const sockaddr_in& addr, KeySpace& keys, const Choosers& choosers, uint64_t seed)
+        : opt_(opt), client_(opt, addr), keys_(keys), rng_(seed), value_(opt.value_size, 'v'),
+          uniform_(keys.records), zipf_(choosers.zipf), latest_(choosers.latest),
+          scan_len_(1, opt.max_scan) {}
+
+    // Load phase: inserts key numbers [first, last)
+    void load(uint64_t first, uint64_t last) {
+        for (uint64_t k = first; k < last; ++k) timed(INSERT, [&] { return insert(k); });
+    }
+
+    // Run phase: `count` operations drawn from the workload mix
+    void run(uint64_t count) {
+        std::discrete_distribution<int> mix(std::begin(opt_.workload.proportion),
+                                            std::end(opt_.workload.proportion));
+        for (uint64_t i = 0; i < count; ++i) {
+            Op op = static_cast<Op>(mix(rng_));
+            switch (op) {
+                case READ: timed(op, [&] { return read(next_key()); }); break;
+                case UPDATE: timed(op, [&] { return update(next_key()); }); break;
+                case SCAN: timed(op, [&] { return scan(next_key(), scan_len_(rng_)); }); break;
+                case READ_MODIFY_WRITE:
+                    timed(op, [&] {
+                        uint64_t k = next_key();
+                        return read(k) && update(k);
+                    });
+                    break;
+                case INSERT:
+                    timed(op, [&] {
+                        uint64_t k = keys_.next_insert.fetch_add(1, std::memory_order_relaxed);
+                        bool ok = insert(k);
+                        acknowledge(k);
+                        return ok;
+                    });
+                    break;
+                default: break;
+            }
+        }
+    }
+
+    const OpStats& stats(Op op) const { return stats_[op]; }
+
+private:
+    const Options& opt_;
+    Client client_;
+    KeySpace& keys_;
+    std::mt19937_64 rng_;
+    std::string value_;
+    UniformChooser uniform_;
+    ScrambledZipfianChooser zipf_;
+    LatestChooser latest_;
+    std::uniform_int_distribution<uint64_t> scan_len_;
+    OpStats stats_[OP_COUNT];
+
+    template <typename Fn>
+    void timed(Op op, Fn&& fn) {
+        uint64_t start = now_ns();
+        if (fn()) stats_[op].latency.record(now_ns() - start);
+        else stats_[op].errors++;
+    }
+
+    // Uniform and zipfian cover the loaded records; latest follows inserts
+    uint64_t next_key() {
+        switch (opt_.workload.dist) {
+            case DIST_UNIFORM: return uniform_.next(rng_);
+            case DIST_ZIPFIAN: return zipf_.next(rng_);
+            case DIST_LATEST:
+                latest_.grow(keys_.acknowledged.load(std::memory_order_relaxed));
+                return latest_.next(rng_);
+        }
+        return 0;
+    }
+
+    // Raises the acknowledged bound to cover key k. Inserts from other
+    // threads may still be in flight below it, as with YCSB under load.
+    void acknowledge(uint64_t k) {
+        uint64_t seen = keys_.acknowledged.load(std::memory_order_relaxed);
+        while (seen < k + 1 && !keys_.acknowledged.compare_exchange_weak(seen, k + 1, std::memory_order_relaxed)) {}
+    }
+
+    std::string key_name(uint64_t k) const {
+        return opt_.key_prefix + std::to_string(opt_.hashed_keys ? ScrambledZipfianChooser::fnv1a(k) : k);
+    }
+
+    static std::string resp_bulk(const std::string& s) {
+        return "$" + std::to_string(s.size()) + "\r\n" + s + "\r\n";
+    }
+
+    bool read(uint64_t k) {
+        std::string key = key_name(k);
+        if (opt_.resp) return client_.call("*2\r\n$3\r\nGET\r\n" + resp_bulk(key));
+        return client_.call("GET /" + key + " HTTP/1.1\r\nHost: " + opt_.host + "\r\n\r\n");
+    }
+
+    bool write(uint64_t k) {
+        std::string key = key_name(k);
+        if (opt_.resp) return client_.call("*3\r\n$3\r\nSET\r\n" + resp_bulk(key) + resp_bulk(value_));
+        return client_.call("POST /" + key + " HTTP/1.1\r\nHost: " + opt_.host + "\r\nContent-Length: " +
+                            std::to_string(value_.size()) + "\r\n\r\n" + value_);
+    }
+
+    bool insert(uint64_t k) { return write(k); }
+    bool update(uint64_t k) { return write(k); }
+
+    bool scan(uint64_t k, uint64_t len) {
+        if (!opt_.resp) {
+            return client_.call("GET /" + key_name(k) + "?scan=" + std::to_string(len) +
+                                " HTTP/1.1\r\nHost: " + opt_.host + "\r\n\r\n");
+        }
+        std::string cmd = "*" + std::to_string(len + 1) + "\r\n$4\r\nMGET\r\n";
+        for (uint64_t i = 0; i < len; ++i) cmd += resp_bulk(key_name(k + i));
+        return client_.call(cmd);
+    }
+};
+
+// Runs one phase on opt.threads clients; `work(runner, thread)` does the share of thread t
+template <typename Work>
+PhaseResult run_phase(const char* name, const Options& opt, const sockaddr_in& addr, KeySpace& keys,
+                      const Choosers& choosers, Work work) {
+    std::vector<std::unique_ptr<Runner>> runners;
+    for (int t = 0; t < opt.threads; ++t) {
+        runners.push_back(std::make_unique<Runner>(opt, addr, keys, choosers, 0x9e3779b97f4a7c15ull * (t + 1)));
+    }
+
+    uint64_t start = now_ns();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < opt.threads; ++t) threads.emplace_back([&, t] { work(*runners[t], t); });
+    for (auto& th : threads) th.join();
+
+    PhaseResult result;
+    result.phase = name;
+    result.runtime_s = (now_ns() - start) / 1e9;
+    for (auto& r : runners) {
+        for (int op = 0; op < OP_COUNT; ++op) {
+            r->stats(static_cast<Op>(op)).latency.merge_into(result.latency[op]);
+            result.errors[op] += r->stats(static_cast<Op>(op)).errors;
+        }
+    }
+    return result;
+}
+
+uint64_t total_ops(const PhaseResult& r) {
+    uint64_t total = 0;
+    for (int op = 0; op < OP_COUNT; ++op) total += r.latency[op].count + r.errors[op];
+    return total;
+}
+
+uint64_t total_errors(const PhaseResult& r) {
+    uint64_t total = 0;
+    for (uint64_t e : r.errors) total += e;
+    return total;
+}
+
+void report_text(const std::vector<PhaseResult>& phases) {
+    for (const auto& r : phases) {
+        uint64_t ops = total_ops(r);
+        std::printf("[%s], Workload phase\n", r.phase);
+        std::printf("[OVERALL], RunTime(ms), %.0f\n", r.runtime_s * 1e3);
+        std::printf("[OVERALL], Throughput(ops/sec), %.1f\n", r.runtime_s > 0 ? ops / r.runtime_s : 0.0);
+        for (int op = 0; op < OP_COUNT; ++op) {
+            const auto& lat = r.latency[op];
+            if (lat.count == 0 && r.errors[op] == 0) continue;
+            const char* name = op_name(static_cast<Op>(op));
+            std::printf("[%s], Operations, %llu\n", name, static_cast<unsigned long long>(lat.count));
+            std::printf("[%s], AverageLatency(us), %.1f\n", name, lat.count ? lat.sum / 1e3 / lat.count : 0.0);
+            std::printf("[%s], 50thPercentileLatency(us), %.1f\n", name, lat.percentile(0.5) / 1e3);
+            std::printf("[%s], 95thPercentileLatency(us), %.1f\n", name, lat.percentile(0.95) / 1e3);
+            std::printf("[%s], 99thPercentileLatency(us), %.1f\n", name, lat.percentile(0.99) / 1e3);
+            std::printf("[%s], 99.9thPercentileLatency(us), %.1f\n", name, lat.percentile(0.999) / 1e3);
+            std::printf("[%s], MaxLatency(us), %.1f\n", name, lat.max / 1e3);
+            std::printf("[%s], Errors, %llu\n", name, static_cast<unsigned long long>(r.errors[op]));
+        }
+    }
+}
+
+void report_json(const Options& opt, const std::vector<PhaseResult>& phases) {
+    std::printf("{\"workload\":\"%c\",\"protocol\":\"%s\",\"distribution\":\"%s\",\"records\":%llu,"
+                "\"threads\":%d,\"value_size\":%zu,\"phases\":[",
+                opt.workload.name, opt.resp ? "resp" : "http", dist_name(opt.workload.dist),
+                static_cast<unsigned long long>(opt.records), opt.threads, opt.value_size);
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const auto& r = phases[i];
+        uint64_t ops = total_ops(r);
+        std::printf("%s{\"phase\":\"%s\",\"runtime_s\":%.3f,\"operations\":%llu,\"errors\":%llu,"
+                    "\"throughput_ops\":%.1f,\"ops\":{",
+                    i ? "," : "", r.phase, r.runtime_s, static_cast<unsigned long long>(ops),
+                    static_cast<unsigned long long>(total_errors(r)), r.runtime_s > 0 ? ops / r.runtime_s : 0.0);
+        bool first = true;
+        for (int op = 0; op < OP_COUNT; ++op) {
+            const auto& lat = r.latency[op];
+            if (lat.count == 0 && r.errors[op] == 0) continue;
+            std::printf("%s\"%s\":{\"count\":%llu,\"errors\":%llu,\"latency_us\":{\"p50\":%.1f,\"p95\":%.1f,"
+                        "\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f,\"mean\":%.1f}}",
+                        first ? "" : ",", op_name(static_cast<Op>(op)), static_cast<unsigned long long>(lat.count),
+                        static_cast<unsigned long long>(r.errors[op]), lat.percentile(0.5) / 1e3,
+                        lat.percentile(0.95) / 1e3, lat.percentile(0.99) / 1e3, lat.percentile(0.999) / 1e3,
+                        lat.max / 1e3, lat.count ? lat.sum / 1e3 / lat.count : 0.0);
+            first = false;
+        }
+        std::printf("}}");
+    }
+    std::printf("]}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options opt = parse_args(argc, argv);
+
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(opt.host.c_str(), std::to_string(opt.port).c_str(), &hints, &res) != 0 || !res) {
+            throw std::runtime_error("cannot resolve " + opt.host);
+        }
+        sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(res->ai_addr);
+        freeaddrinfo(res);
+
+        KeySpace keys;
+        keys.records = opt.records;
+        keys.next_insert = opt.records;
+        keys.acknowledged = opt.records;
+
+        auto share = [&](uint64_t total, int t) {
+            return std::make_pair(total * t / opt.threads, total * (t + 1) / opt.threads);
+        };
+
+        std::vector<PhaseResult> phases;
+        if (opt.load) {
+            // Inserts go in key order, no chooser needed
+            Choosers unused(DIST_UNIFORM, opt.records, opt.theta);
+            phases.push_back(run_phase("LOAD", opt, addr, keys, unused, [&](Runner& r, int t) {
+                auto [first, last] = share(opt.records, t);
+                r.load(first, last);
+            }));
+        }
+        if (opt.run) {
+            Choosers choosers(opt.workload.dist, opt.records, opt.theta);
+            phases.push_back(run_phase("RUN", opt, addr, keys, choosers, [&](Runner& r, int t) {
+                auto [first, last] = share(opt.operations, t);
+                r.run(last - first);
+            }));
+        }
+
+        if (opt.json) report_json(opt, phases);
+        else report_text(phases);
+
+        for (const auto& p : phases) {
+            if (total_ops(p) > 0 && total_errors(p) == total_ops(p)) return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    } catch (const std::exception& e) {
+        std::cerr << "ycsb: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
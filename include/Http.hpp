@@ -43,6 +43,7 @@ private:
             case 200: return "OK";
             case 400: return "Bad Request";
             case 404: return "Not Found";
+            case 409: return "Conflict";
             case 500: return "Internal Server Error";
             default: return "Unknown";
         }
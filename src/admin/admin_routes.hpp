@@ -0,0 +1,272 @@
+#pragma once
+#include "Http.hpp"
+#include "../utils/http_message.hpp"
+#include "../stats/memory_stats.hpp"
+#include "../stats/metrics.hpp"
+#include "../stats/latency.hpp"
+#include "../stats/slowlog.hpp"
+#include "../stats/latency_monitor.hpp"
+#include "../stats/trace.hpp"
+#include "../stats/client_registry.hpp"
+#include "../stats/profiler.hpp"
+#include "../stats/hw_counters.hpp"
+#include "../stats/hotkeys.hpp"
+#include "../debug/debug.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+// Introspection endpoints served by the worker threads alongside regular
+// requests. Anything not matched here falls through to the echo handler.
+namespace admin {
+
+// INFO-style report; `section` picks one section, empty or "all" returns every one
+inline std::string info(const std::string& section) {
+    std::string out;
+    auto wants = [&section](const char* name) {
+        return section.empty() || section == "all" || section == name;
+    };
+
+    if (wants("memory")) out += stats::memory_info();
+    if (wants("clients")) out += stats::ClientRegistry::instance().info_section();
+    if (wants("latencystats")) out += stats::latency_info();
+    if (wants("hwstats")) out += stats::hw_info();
+    return out;
+}
+
+// SLOWLOG GET/LEN/RESET, plus /slowlog/config?slower-than=<usec> for the threshold
+inline std::string slowlog(const std::string& path, const HttpMessage& request) {
+    auto& log = stats::SlowLog::instance();
+    try {
+        if (path == "/slowlog" || path == "/slowlog/get") {
+            size_t count = std::stoul(request.query_param("count", "10"));
+            return Http::create(200, log.format(count));
+        }
+        if (path == "/slowlog/len") {
+            return Http::create(200, std::to_string(log.len()) + "\n");
+        }
+        if (path == "/slowlog/reset") {
+            log.reset();
+            return Http::create(200, "OK\n");
+        }
+        if (path == "/slowlog/config") {
+            std::string value = request.query_param("slower-than");
+            if (!value.empty()) {
+                int64_t threshold = std::stoll(value);
+                if (threshold > stats::SlowLog::MAX_THRESHOLD_US) return Http::create(400, "invalid argument\n");
+                log.set_threshold_us(threshold);
+            }
+            return Http::create(200, "slower-than:" + std::to_string(log.threshold_us()) + "\n");
+        }
+    } catch (const std::logic_error&) { // std::stoul/stoll on a bad number
+        return Http::create(400, "invalid argument\n");
+    }
+    return Http::create(404, "unknown slowlog subcommand\n");
+}
+
+// LATENCY LATEST/HISTORY/RESET/DOCTOR, plus /latency/config?threshold-us=<usec>
+inline std::string latency(const std::string& path, const HttpMessage& request) {
+    auto& monitor = stats::LatencyMonitor::instance();
+    if (path == "/latency" || path == "/latency/latest") {
+        return Http::create(200, monitor.latest());
+    }
+    if (path == "/latency/history") {
+        std::string out;
+        if (!monitor.history(request.query_param("event"), out)) {
+            return Http::create(400, "unknown event\n");
+        }
+        return Http::create(200, out);
+    }
+    if (path == "/latency/reset") {
+        monitor.reset();
+        return Http::create(200, "OK\n");
+    }
+    if (path == "/latency/doctor") {
+        return Http::create(200, monitor.doctor());
+    }
+    if (path == "/latency/config") {
+        try {
+            std::string value = request.query_param("threshold-us");
+            if (!value.empty()) monitor.set_threshold_us(std::stoll(value));
+        } catch (const std::logic_error&) {
+            return Http::create(400, "invalid argument\n");
+        }
+        return Http::create(200, "threshold-us:" + std::to_string(monitor.threshold_us()) + "\n");
+    }
+    return Http::create(404, "unknown latency subcommand\n");
+}
+
+// CLIENT LIST and CLIENT KILL. Both take the same filters: id, addr,
+// min-idle (seconds), maxage (seconds) and min-obuf (bytes). KILL needs at
+// least one and never kills the connection that sent it.
+inline std::string clients(const std::string& path, const HttpMessage& request) {
+    auto& registry = stats::ClientRegistry::instance();
+    stats::ClientFilter filter;
+    try {
+        std::string value;
+        if (!(value = request.query_param("id")).empty()) filter.id = std::stoull(value);
+        filter.addr = request.query_param("addr");
+        if (!(value = request.query_param("min-idle")).empty()) filter.min_idle_s = std::stoll(value);
+        if (!(value = request.query_param("maxage")).empty()) filter.max_age_s = std::stoll(value);
+        if (!(value = request.query_param("min-obuf")).empty()) filter.min_obuf = std::stoll(value);
+    } catch (const std::logic_error&) {
+        return Http::create(400, "invalid argument\n");
+    }
+    // Seconds are converted to nanoseconds when matching, so bound them here
+    auto out_of_range = [](int64_t seconds) { return seconds > stats::ClientFilter::MAX_SECONDS; };
+    if (out_of_range(filter.min_idle_s) || out_of_range(filter.max_age_s)) {
+        return Http::create(400, "invalid argument\n");
+    }
+
+    if (path == "/clients" || path == "/clients/list") {
+        return Http::create(200, registry.format_list(filter));
+    }
+    if (path == "/clients/kill") {
+        if (filter.empty()) return Http::create(400, "kill needs a filter\n");
+        return Http::create(200, "killed:" + std::to_string(registry.kill(filter)) + "\n");
+    }
+    return Http::create(404, "unknown clients subcommand\n");
+}
+
+// Samples CPU stacks of the whole server for ?seconds= (default 5) at
+// ?hz= (default 99) and returns them folded for flamegraph.pl. ?threads=0
+// merges all threads into one graph. Blocks this worker for the duration.
+inline std::string profile(const HttpMessage& request) {
+    int seconds, hz;
+    try {
+        seconds = std::stoi(request.query_param("seconds", "5"));
+        hz = std::stoi(request.query_param("hz", "99"));
+    } catch (const std::logic_error&) {
+        return Http::create(400, "invalid argument\n");
+    }
+    if (seconds <= 0 || hz <= 0) return Http::create(400, "seconds and hz must be positive\n");
+    stats::Profiler::Result result = stats::Profiler::run(seconds, hz, request.query_param("threads", "1") != "0");
+    if (result.busy) return Http::create(409, "a profile is already running\n");
+    if (!result.ok) return Http::create(500, "profiler failed: " + result.error + "\n");
+    return Http::create(200, result.folded, "text/plain",
+        {{"X-Profile-Samples", std::to_string(result.samples)},
+         {"X-Profile-Dropped", std::to_string(result.dropped)}});
+}
+
+// HOTKEYS: the ?count= (default 10) most accessed keys over the last few
+// decay periods, merged from every worker. /hotkeys/reset clears them.
+inline std::string hotkeys(const std::string& path, const HttpMessage& request) {
+    if (path == "/hotkeys/reset") {
+        stats::reset_hotkeys();
+        return Http::create(200, "OK\n");
+    }
+    size_t count;
+    try {
+        count = std::stoul(request.query_param("count", "10"));
+    } catch (const std::logic_error&) {
+        return Http::create(400, "invalid argument\n");
+    }
+    return Http::create(200, stats::format_hotkeys(count));
+}
+
+// Fills `response` and returns true if the request targets an admin endpoint.
+// `timer` is set to the route's latency histogram.
+inline bool dispatch(const HttpMessage& request, std::string& response, stats::Timer& timer) {
+    if (request.method() != "GET") return false;
+
+    const std::string path = request.path();
+    if (path == "/info") {
+        stats::add(stats::CALLS_INFO);
+        timer = stats::ROUTE_INFO;
+        response = Http::create(200, info(request.query_param("section")));
+        return true;
+    }
+    if (path == "/metrics") {
+        stats::add(stats::CALLS_METRICS);
+        timer = stats::ROUTE_METRICS;
+        response = Http::create(200, stats::prometheus_text(), "text/plain; version=0.0.4");
+        return true;
+    }
+    if (path.rfind("/slowlog", 0) == 0) {
+        stats::add(stats::CALLS_SLOWLOG);
+        timer = stats::ROUTE_SLOWLOG;
+        response = slowlog(path, request);
+        return true;
+    }
+    if (path.rfind("/latency", 0) == 0) {
+        stats::add(stats::CALLS_LATENCY);
+        timer = stats::ROUTE_LATENCY;
+        response = latency(path, request);
+        return true;
+    }
+    if (path.rfind("/clients", 0) == 0) {
+        stats::add(stats::CALLS_CLIENT);
+        timer = stats::ROUTE_CLIENT;
+        response = clients(path, request);
+        return true;
+    }
+    if (path == "/profile") {
+        stats::add(stats::CALLS_PROFILE);
+        timer = stats::ROUTE_PROFILE;
+        response = profile(request);
+        return true;
+    }
+    if (path == "/hwstats" || path == "/hwstats/config") {
+        stats::add(stats::CALLS_HWSTATS);
+        timer = stats::ROUTE_HWSTATS;
+        try {
+            std::string value = request.query_param("sample-rate");
+            if (!value.empty()) {
+                unsigned long rate = std::stoul(value);
+                if (rate > UINT32_MAX) throw std::out_of_range("sample-rate");
+                stats::hw_sample_rate.store(static_cast<uint32_t>(rate));
+            }
+            response = Http::create(200, stats::hw_info());
+        } catch (const std::logic_error&) {
+            response = Http::create(400, "invalid argument\n");
+        }
+        return true;
+    }
+    if (path == "/hotkeys" || path == "/hotkeys/reset") {
+        stats::add(stats::CALLS_HOTKEYS);
+        timer = stats::ROUTE_HOTKEYS;
+        response = hotkeys(path, request);
+        return true;
+    }
+    if (path == "/trace") {
+        stats::add(stats::CALLS_TRACE);
+        timer = stats::ROUTE_TRACE;
+        response = Http::create(200, trace::dump_json(), "application/json");
+        return true;
+    }
+    if (path == "/loglevel") {
+        stats::add(stats::CALLS_LOGLEVEL);
+        timer = stats::ROUTE_LOGLEVEL;
+        std::string value = request.query_param("level");
+        if (!value.empty()) {
+            int level = dbg::parse_level(value);
+            if (level < 0) {
+                response = Http::create(400, "invalid level\n");
+                return true;
+            }
+            dbg::set_level(level);
+        }
+        response = Http::create(200, std::string("level:") + dbg::level_name(dbg::level()) +
+            " compiled:" + dbg::level_name(DBG_COMPILE_LEVEL) + "\n");
+        return true;
+    }
+    if (path == "/trace/config") {
+        stats::add(stats::CALLS_TRACE);
+        timer = stats::ROUTE_TRACE;
+        try {
+            std::string value = request.query_param("sample-rate");
+            if (!value.empty()) {
+                unsigned long rate = std::stoul(value);
+                if (rate > UINT32_MAX) throw std::out_of_range("sample-rate");
+                trace::sample_rate.store(static_cast<uint32_t>(rate));
+            }
+            response = Http::create(200, "sample-rate:" + std::to_string(trace::sample_rate.load()) + "\n");
+        } catch (const std::logic_error&) {
+            response = Http::create(400, "invalid argument\n");
+        }
+        return true;
+    }
+    return false;
+}
+
+} // namespace admin
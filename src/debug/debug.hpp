@@ -22,6 +22,18 @@
 #include <variant>      // std::variant
 #include <iomanip>      // std::boolalpha
 #include <iterator>     // std::begin, std::end
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>      // std::getenv
+#include <cstring>      // std::memcpy, std::strlen
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <cctype>
 
 // --- Configuration ---
 // Define DBG_OUTPUT_STREAM to change the output stream (default: std::cerr)
@@ -245,37 +257,490 @@ void print_debug_vars(std::ostream& os, const char* names, const T& first, const
 
 } // namespace dbg
 
+// --- Leveled, deferred logging ---
+//
+// DEBUG/LOG_* calls do not format on the calling thread. Arguments are
+// encoded as raw binary (numbers, pointers, string bytes) into a per-thread
+// ring buffer; a background thread decodes and formats them later. Types
+// without a binary encoding (containers, user types) are formatted eagerly
+// with pretty_print and carried as text.
+//
+// Levels below DBG_COMPILE_LEVEL compile away entirely. The remaining ones
+// are filtered at runtime by dbg::set_level() or the DBG_LEVEL environment
+// variable (a level name or number). When a thread's ring is full the
+// record is dropped rather than blocking the caller.
+
+#define DBG_LEVEL_TRACE 0
+#define DBG_LEVEL_DEBUG 1
+#define DBG_LEVEL_INFO  2
+#define DBG_LEVEL_WARN  3
+#define DBG_LEVEL_ERROR 4
+#define DBG_LEVEL_OFF   5
+
+// Define DBG_COMPILE_LEVEL to drop every level below it at compile time
+#ifndef DBG_COMPILE_LEVEL
+    #if IS_DEBUG_ENABLED
+        #define DBG_COMPILE_LEVEL DBG_LEVEL_TRACE
+    #else
+        #define DBG_COMPILE_LEVEL DBG_LEVEL_INFO
+    #endif
+#endif
+
+// Define DBG_RING_BYTES to change the per-thread log buffer (power of two)
+#ifndef DBG_RING_BYTES
+#define DBG_RING_BYTES (256 * 1024)
+#endif
+
+namespace dbg {
+
+inline const char* level_name(int level) {
+    switch (level) {
+        case DBG_LEVEL_TRACE: return "TRACE";
+        case DBG_LEVEL_DEBUG: return "DEBUG";
+        case DBG_LEVEL_INFO: return "INFO";
+        case DBG_LEVEL_WARN: return "WARN";
+        case DBG_LEVEL_ERROR: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+// Accepts a level name ("info", "WARN") or number; returns -1 if invalid
+inline int parse_level(const std::string& text) {
+    for (int level = DBG_LEVEL_TRACE; level <= DBG_LEVEL_OFF; ++level) {
+        std::string name = level_name(level);
+        if (text.size() == name.size() &&
+            std::equal(text.begin(), text.end(), name.begin(),
+                       [](char a, char b) { return std::toupper((unsigned char)a) == b; })) {
+            return level;
+        }
+    }
+    if (text.size() == 1 && text[0] >= '0' && text[0] <= '5') return text[0] - '0';
+    return -1;
+}
+
+inline int initial_level() {
+    const char* env = std::getenv("DBG_LEVEL");
+    int level = env ? parse_level(env) : -1;
+    return level >= 0 ? level : DBG_COMPILE_LEVEL;
+}
+
+inline std::atomic<int> runtime_level_{initial_level()};
+
+inline int level() { return runtime_level_.load(std::memory_order_relaxed); }
+inline void set_level(int level) { runtime_level_.store(level, std::memory_order_relaxed); }
+
+// Static description of one log call site; only its address is logged
+struct LogSite {
+    const char* file;
+    int line;
+    int level;
+    const char* msg;    // May be nullptr
+    const char* names;  // Stringified argument list
+};
+
+namespace detail {
+
+enum Tag : uint8_t { TAG_BOOL, TAG_CHAR, TAG_I64, TAG_U64, TAG_F64, TAG_PTR, TAG_STR, TAG_TEXT };
+
+template <typename T>
+void put(std::string& buf, const T& value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+inline void put_bytes(std::string& buf, Tag tag, const char* data, size_t len) {
+    buf.push_back(static_cast<char>(tag));
+    put(buf, static_cast<uint32_t>(len));
+    buf.append(data, len);
+}
+
+template <typename T>
+void encode(std::string& buf, const T& value) {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>) {
+        buf.push_back(static_cast<char>(TAG_BOOL));
+        buf.push_back(value ? 1 : 0);
+    } else if constexpr (std::is_same_v<D, char>) {
+        buf.push_back(static_cast<char>(TAG_CHAR));
+        buf.push_back(value);
+    } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+        buf.push_back(static_cast<char>(TAG_I64));
+        put(buf, static_cast<int64_t>(value));
+    } else if constexpr (std::is_integral_v<D>) {
+        buf.push_back(static_cast<char>(TAG_U64));
+        put(buf, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_floating_point_v<D>) {
+        buf.push_back(static_cast<char>(TAG_F64));
+        put(buf, static_cast<double>(value));
+    } else if constexpr (std::is_enum_v<D>) {
+        encode(buf, static_cast<std::underlying_type_t<D>>(value));
+    } else if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) {
+        // String literals and char buffers: never null, bounded by the array
+        put_bytes(buf, TAG_STR, value, strnlen(value, std::extent_v<T>));
+    } else if constexpr (std::is_same_v<D, const char*> || std::is_same_v<D, char*>) {
+        if (value) put_bytes(buf, TAG_STR, value, std::strlen(value));
+        else put_bytes(buf, TAG_TEXT, "nullptr (char*)", 15);
+    } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+        put_bytes(buf, TAG_STR, value.data(), value.size());
+    } else if constexpr (std::is_null_pointer_v<D>) {
+        put_bytes(buf, TAG_TEXT, "nullptr", 7);
+    } else if constexpr (std::is_pointer_v<D>) {
+        buf.push_back(static_cast<char>(TAG_PTR));
+        put(buf, reinterpret_cast<uintptr_t>(value));
+    } else {
+        // No binary form: format now and carry the text
+        std::ostringstream os;
+        pretty_print(os, value);
+        std::string text = os.str();
+        put_bytes(buf, TAG_TEXT, text.data(), text.size());
+    }
+}
+
+// Record layout: [u32 length][LogSite*][i64 unix time ns][u32 thread][args...]
+struct RecordHeader {
+    uint32_t length;
+    const LogSite* site;
+    int64_t time_ns;
+    uint32_t thread;
+};
+
+// Single-producer single-consumer byte ring owned by one logging thread
+struct LogRing {
+    static constexpr size_t CAPACITY = DBG_RING_BYTES;
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "DBG_RING_BYTES must be a power of two");
+
+    const uint32_t thread;
+    std::atomic<uint64_t> head{0};   // Written by the producer
+    std::atomic<uint64_t> tail{0};   // Written by the consumer
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> orphaned{false}; // Producer thread has exited
+    std::unique_ptr<char[]> data{new char[CAPACITY]};
+
+    explicit LogRing(uint32_t thread) : thread(thread) {}
+
+    bool push(const std::string& record) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        if (record.size() > CAPACITY - (h - t)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        copy_in(h, record.data(), record.size());
+        head.store(h + record.size(), std::memory_order_release);
+        return true;
+    }
+
+    void copy_in(uint64_t pos, const char* src, size_t len) {
+        size_t offset = pos & (CAPACITY - 1);
+        size_t first = std::min(len, CAPACITY - offset);
+        std::memcpy(data.get() + offset, src, first);
+        std::memcpy(data.get(), src + first, len - first);
+    }
+
+    void copy_out(uint64_t pos, char* dst, size_t len) const {
+        size_t offset = pos & (CAPACITY - 1);
+        size_t first = std::min(len, CAPACITY - offset);
+        std::memcpy(dst, data.get() + offset, first);
+        std::memcpy(dst + first, data.get(), len - first);
+    }
+};
+
+// Next argument name in a stringified argument list, honouring
+// parentheses, brackets and string/char literals
+inline std::string_view next_name(const char*& names) {
+    while (*names == ' ' || *names == '\t') ++names;
+    const char* start = names;
+    int depth = 0;
+    char quote = 0;
+    for (; *names != '\0'; ++names) {
+        char c = *names;
+        if (quote) {
+            if (c == '\\' && names[1] != '\0') ++names;
+            else if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '(' || c == '[' || c == '{') {
+            ++depth;
+        } else if (c == ')' || c == ']' || c == '}') {
+            --depth;
+        } else if (c == ',' && depth == 0) {
+            break;
+        }
+    }
+    std::string_view name(start, names - start);
+    if (*names == ',') ++names;
+    while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
+    return name;
+}
+
+template <typename T>
+T take(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return value;
+}
+
+// Formats one record; `p` points just past the header
+inline void format_record(std::ostream& os, const RecordHeader& h, const char* p, const char* end) {
+    std::time_t secs = static_cast<std::time_t>(h.time_ns / 1000000000);
+    std::tm tm{};
+    localtime_r(&secs, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%H:%M:%S", &tm);
+
+    os << "[" << stamp << "." << std::setw(6) << std::setfill('0') << (h.time_ns / 1000) % 1000000
+       << std::setfill(' ') << "] [" << level_name(h.site->level) << "] [t" << h.thread << "] ["
+       << h.site->file << ":" << h.site->line << "]";
+    if (h.site->msg) os << " " << h.site->msg;
+
+    const char* names = h.site->names;
+    bool after_value = false; // Values are separated by "; ", literals by a space
+    while (p < end) {
+        std::string_view name = next_name(names);
+        Tag tag = static_cast<Tag>(*p++);
+
+        // A bare string literal argument is printed as-is, without "name = "
+        bool literal = !name.empty() && name.front() == '"' && tag == TAG_STR;
+        os << (after_value && !literal ? "; " : " ");
+        after_value = !literal;
+        if (!literal) os << name << " = ";
+
+        switch (tag) {
+            case TAG_BOOL: os << std::boolalpha << (*p++ != 0); break;
+            case TAG_CHAR: os << "'" << *p++ << "'"; break;
+            case TAG_I64: os << take<int64_t>(p); break;
+            case TAG_U64: os << take<uint64_t>(p); break;
+            case TAG_F64: os << take<double>(p); break;
+            case TAG_PTR: os << reinterpret_cast<const void*>(take<uintptr_t>(p)); break;
+            case TAG_STR:
+            case TAG_TEXT: {
+                uint32_t len = take<uint32_t>(p);
+                std::string_view text(p, len);
+                p += len;
+                if (tag == TAG_STR && !literal) os << std::quoted(text);
+                else os << text;
+                break;
+            }
+        }
+    }
+    os << "\n";
+}
+
+// Appends everything written to it to a std::string, so one buffer (and
+// its capacity) is reused across drains
+class StringSink : public std::streambuf {
+    std::string& out_;
+
+public:
+    explicit StringSink(std::string& out) : out_(out) {}
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) out_.push_back(static_cast<char>(c));
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        out_.append(s, static_cast<size_t>(n));
+        return n;
+    }
+};
+
+// Owns every thread's ring and the background formatting thread.
+//
+// The formatter blocks while every ring is empty. Producers only look at
+// `parked_` after a push and notify when the formatter is asleep, so a
+// busy formatter is never signalled and an idle server never wakes it.
+class Logger {
+    std::mutex rings_mutex_;
+    std::vector<std::unique_ptr<LogRing>> rings_;
+    uint32_t next_thread_ = 1;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> parked_{false};
+    bool stopping_ = false;
+
+    // Formatter-only state, reused across drains
+    std::vector<LogRing*> snapshot_;
+    std::vector<char> record_;
+    std::string text_;
+    StringSink sink_{text_};
+    std::ostream out_{&sink_};
+
+    std::thread worker_;
+
+    Logger() : worker_([this] { run(); }) {}
+
+    bool pending() {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            if (ring->head.load(std::memory_order_acquire) != ring->tail.load(std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Formats everything currently buffered. The ring list is copied out
+    // first so a new thread's create_ring() never waits behind formatting;
+    // only this thread removes rings, so the copied pointers stay valid.
+    void drain() {
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            snapshot_.clear();
+            for (const auto& ring : rings_) snapshot_.push_back(ring.get());
+        }
+
+        text_.clear();
+        uint64_t dropped = 0;
+        bool orphans = false;
+        for (LogRing* ring : snapshot_) {
+            uint64_t t = ring->tail.load(std::memory_order_relaxed);
+            uint64_t h = ring->head.load(std::memory_order_acquire);
+            while (t < h) {
+                uint32_t length;
+                ring->copy_out(t, reinterpret_cast<char*>(&length), sizeof(length));
+                record_.resize(length);
+                ring->copy_out(t, record_.data(), length);
+
+                RecordHeader header;
+                std::memcpy(&header, record_.data(), sizeof(header));
+                format_record(out_, header, record_.data() + sizeof(header), record_.data() + length);
+                t += length;
+            }
+            ring->tail.store(t, std::memory_order_release);
+            dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+            orphans |= ring->orphaned.load(std::memory_order_acquire);
+        }
+        if (dropped) out_ << "[dbg] " << dropped << " log records dropped (ring full)\n";
+
+        // Rings of exited threads go away once drained
+        if (orphans) {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const std::unique_ptr<LogRing>& ring) {
+                return ring->orphaned.load(std::memory_order_acquire) &&
+                       ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_relaxed);
+            }), rings_.end());
+        }
+
+        if (text_.empty()) return;
+        DBG_OUTPUT_STREAM.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+        DBG_OUTPUT_STREAM.flush();
+    }
+
+    void run() {
+        while (true) {
+            drain();
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            if (stopping_) break;
+            // Announce the nap before the last look at the rings; pairs
+            // with the fence in notify_if_parked() so no push is missed
+            parked_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending()) {
+                wake_.wait(lock, [this] { return stopping_ || !parked_.load(std::memory_order_relaxed); });
+            }
+            parked_.store(false, std::memory_order_relaxed);
+        }
+        drain();
+    }
+
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    LogRing* create_ring() {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::make_unique<LogRing>(next_thread_++));
+        return rings_.back().get();
+    }
+
+    // Called by producers after a push; a relaxed load unless the formatter sleeps
+    void notify_if_parked() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!parked_.load(std::memory_order_relaxed)) return;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            parked_.store(false, std::memory_order_relaxed);
+        }
+        wake_.notify_one();
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+};
+
+// Flags the calling thread's ring as orphaned when the thread exits
+struct RingHandle {
+    LogRing* ring = Logger::instance().create_ring();
+    ~RingHandle() { ring->orphaned.store(true, std::memory_order_release); }
+};
+
+inline LogRing& local_ring() {
+    thread_local RingHandle handle;
+    return *handle.ring;
+}
+
+} // namespace detail
+
+// Encodes one record into the calling thread's ring
+template <typename... Args>
+void log_deferred(const LogSite& site, const Args&... args) {
+    thread_local std::string buf;
+    buf.clear();
+    detail::RecordHeader header{0, &site,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count(), 0};
+    detail::LogRing& ring = detail::local_ring();
+    header.thread = ring.thread;
+    detail::put(buf, header);
+    (detail::encode(buf, args), ...);
+
+    uint32_t length = static_cast<uint32_t>(buf.size());
+    std::memcpy(buf.data(), &length, sizeof(length));
+    if (ring.push(buf)) detail::Logger::instance().notify_if_parked();
+}
+
+} // namespace dbg
+
+// DBG_LOG(lvl, "message" or nullptr, var1, var2, ...)
+// The message must be a string literal (or nullptr): only its address is logged.
+#define DBG_LOG(lvl, msg, ...) \
+    do { \
+        if constexpr ((lvl) >= DBG_COMPILE_LEVEL) { \
+            if ((lvl) >= dbg::level()) { \
+                static constexpr dbg::LogSite dbg_site_{__FILE__, __LINE__, (lvl), msg, #__VA_ARGS__}; \
+                dbg::log_deferred(dbg_site_, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_TRACE(msg, ...) DBG_LOG(DBG_LEVEL_TRACE, msg, ##__VA_ARGS__)
+#define LOG_DEBUG(msg, ...) DBG_LOG(DBG_LEVEL_DEBUG, msg, ##__VA_ARGS__)
+#define LOG_INFO(msg, ...)  DBG_LOG(DBG_LEVEL_INFO, msg, ##__VA_ARGS__)
+#define LOG_WARN(msg, ...)  DBG_LOG(DBG_LEVEL_WARN, msg, ##__VA_ARGS__)
+#define LOG_ERROR(msg, ...) DBG_LOG(DBG_LEVEL_ERROR, msg, ##__VA_ARGS__)
+
 // --- User-facing Macros ---
 
 // DEBUG(var1, var2, ...) macro
-// Prints file:line, variable names, and their values to DBG_OUTPUT_STREAM
-// Only active if IS_DEBUG_ENABLED is true
-#if IS_DEBUG_ENABLED
-    #define DEBUG(...) \
-        do { \
-            DBG_OUTPUT_STREAM << "[" << __FILE__ << ":" << __LINE__ << "]"; \
-            dbg::print_debug_vars(DBG_OUTPUT_STREAM, #__VA_ARGS__, __VA_ARGS__); \
-        } while (0)
-#else
-    #define DEBUG(...) do {} while (0) // Compile away to nothing
-#endif
+// Logs file:line, variable names, and their values at DEBUG level
+#define DEBUG(...) DBG_LOG(DBG_LEVEL_DEBUG, nullptr, __VA_ARGS__)
 
 // DEBUG_MSG("message", var1, var2, ...) macro
-// Prints a custom message followed by variables
-#if IS_DEBUG_ENABLED
-    // Use C++17 if constexpr to check if __VA_ARGS__ is empty
-    #define DEBUG_MSG(msg, ...) \
-        do { \
-            DBG_OUTPUT_STREAM << "[" << __FILE__ << ":" << __LINE__ << "] " << msg; \
-            if constexpr (sizeof...(__VA_ARGS__) > 0) { \
-                 dbg::print_debug_vars(DBG_OUTPUT_STREAM, #__VA_ARGS__, __VA_ARGS__); \
-            } else { \
-                 DBG_OUTPUT_STREAM << std::endl; \
-            } \
-        } while (0)
-#else
-    #define DEBUG_MSG(msg, ...) do {} while (0) // Compile away to nothing
-#endif
+// Logs a custom message followed by variables at DEBUG level
+#define DEBUG_MSG(msg, ...) DBG_LOG(DBG_LEVEL_DEBUG, msg, ##__VA_ARGS__)
 
 // --- Force Macros (always enabled) ---
 // Useful for critical errors even in release builds, but use sparingly.
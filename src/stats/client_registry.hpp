@@ -0,0 +1,307 @@
+#pragma once
+#include "thread_counters.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+namespace stats {
+
+// Point-in-time copy of one registered connection
+struct ClientInfo {
+    static constexpr size_t ADDR_LEN = 48;
+    static constexpr size_t CMD_LEN = 16;
+    static constexpr size_t PATH_LEN = 96;
+
+    uint64_t id = 0;
+    int fd = -1;
+    int worker = -1;          // -1 while waiting in the accept queue
+    int64_t created_ns = 0;   // steady_clock
+    int64_t last_active_ns = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    int64_t qbuf = 0;         // Query (input) buffer bytes held now
+    int64_t obuf = 0;         // Output buffer bytes held now
+    char addr[ADDR_LEN] = {}; // "ip:port"
+    char cmd[CMD_LEN] = {};   // Method of the current request, empty before it is parsed
+    char path[PATH_LEN] = {}; // Path of the current request, truncated
+};
+
+// Selects clients for CLIENT LIST and CLIENT KILL; unset fields match all
+struct ClientFilter {
+    // Largest idle/age bound that still fits in nanoseconds (about 292 years)
+    static constexpr int64_t MAX_SECONDS = INT64_MAX / 1000000000;
+
+    uint64_t id = 0;
+    std::string addr;
+    int64_t min_idle_s = -1; // Idle at least this long
+    int64_t max_age_s = -1;  // Connected longer than this (as Redis MAXAGE)
+    int64_t min_obuf = -1;   // Output buffer at least this large
+
+    bool empty() const { return id == 0 && addr.empty() && min_idle_s < 0 && max_age_s < 0 && min_obuf < 0; }
+
+    bool matches(const ClientInfo& c, int64_t now_ns) const {
+        if (id && c.id != id) return false;
+        if (!addr.empty() && addr != c.addr) return false;
+        if (min_idle_s >= 0 && now_ns - c.last_active_ns < min_idle_s * 1000000000) return false;
+        if (max_age_s >= 0 && now_ns - c.created_ns <= max_age_s * 1000000000) return false;
+        if (min_obuf >= 0 && c.obuf < min_obuf) return false;
+        return true;
+    }
+};
+
+// Registry of live connections (CLIENT LIST / CLIENT KILL).
+//
+// Each connection owns one slot from a fixed table. Only the thread that
+// currently owns the connection writes to its slot: first the accept
+// thread, then the worker it is handed to. The byte and buffer counters
+// are plain relaxed stores, and the descriptive fields sit under a
+// per-slot seqlock as in SlowLog, so updates never block. Readers copy
+// slots without locking and skip those that change under them.
+//
+// Killing and closing share a small per-slot mutex so a kill never shuts
+// down an fd number the owner has already closed and the kernel reused.
+// When the table is full, new connections are served but not tracked.
+class ClientRegistry {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+    struct alignas(64) Slot {
+        std::atomic<bool> in_use{false};
+        std::atomic<uint64_t> seq{0}; // Odd while the owner rewrites `info`
+        std::mutex life;              // Held while killing or closing
+        std::atomic<int> fd{-1};
+        std::atomic<int> worker{-1};
+        std::atomic<int64_t> last_active_ns{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<int64_t> qbuf{0};
+        std::atomic<int64_t> obuf{0};
+        ClientInfo info; // id, created_ns, addr, cmd, path; the rest is filled on read
+    };
+
+    static ClientRegistry& instance() {
+        static ClientRegistry registry;
+        return registry;
+    }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Registers a freshly accepted connection; nullptr if the table is full
+    Slot* open(int fd, const std::string& addr) {
+        size_t start = hint_.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            Slot& slot = slots_[(start + i) % CAPACITY];
+            bool expected = false;
+            if (slot.in_use.load(std::memory_order_relaxed) ||
+                !slot.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                continue;
+            }
+            int64_t now = now_ns();
+            slot.worker.store(-1, std::memory_order_relaxed);
+            slot.last_active_ns.store(now, std::memory_order_relaxed);
+            slot.bytes_in.store(0, std::memory_order_relaxed);
+            slot.bytes_out.store(0, std::memory_order_relaxed);
+            slot.qbuf.store(0, std::memory_order_relaxed);
+            slot.obuf.store(0, std::memory_order_relaxed);
+            slot.fd.store(fd, std::memory_order_relaxed);
+            write_info(slot, [&](ClientInfo& info) {
+                info.id = next_id_.fetch_add(1, std::memory_order_relaxed);
+                info.created_ns = now;
+                copy_truncated(info.addr, sizeof(info.addr), addr);
+                info.cmd[0] = '\0';
+                info.path[0] = '\0';
+            });
+            return &slot;
+        }
+        untracked_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Unregisters a connection; call before its fd is closed
+    void close(Slot* slot) {
+        if (!slot) return;
+        if (current_ == slot) current_ = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(slot->life);
+            slot->fd.store(-1, std::memory_order_relaxed);
+        }
+        write_info(*slot, [](ClientInfo& info) { info.id = 0; });
+        slot->in_use.store(false, std::memory_order_release);
+    }
+
+    // Makes `slot` the calling thread's current client; the hooks below update it
+    static void bind(Slot* slot, int worker) {
+        current_ = slot;
+        if (slot) slot->worker.store(worker, std::memory_order_relaxed);
+    }
+    static void unbind() { current_ = nullptr; }
+
+    // --- Hooks called by the owning thread ---
+
+    static void on_bytes_in(uint64_t n) {
+        if (Slot* s = current_) {
+            bump(s->bytes_in, n);
+            s->last_active_ns.store(now_ns(), std::memory_order_relaxed);
+        }
+    }
+
+    static void on_bytes_out(uint64_t n) {
+        if (Slot* s = current_) {
+            bump(s->bytes_out, n);
+            s->last_active_ns.store(now_ns(), std::memory_order_relaxed);
+        }
+    }
+
+    // Mirrors a change to a client memory gauge into the current client's slot
+    static void on_buffer(Stat stat, int64_t delta) {
+        Slot* s = current_;
+        if (!s) return;
+        if (stat == MEM_CLIENT_QUERY_BUF) bump(s->qbuf, delta);
+        else if (stat == MEM_CLIENT_OUTPUT_BUF) bump(s->obuf, delta);
+    }
+
+    static void on_command(const std::string& method, const std::string& path) {
+        Slot* s = current_;
+        if (!s) return;
+        write_info(*s, [&](ClientInfo& info) {
+            copy_truncated(info.cmd, sizeof(info.cmd), method);
+            copy_truncated(info.path, sizeof(info.path), path);
+        });
+        s->last_active_ns.store(now_ns(), std::memory_order_relaxed);
+    }
+
+    // --- Readers ---
+
+    // Every registered client matching `filter`, oldest first
+    std::vector<ClientInfo> list(const ClientFilter& filter = {}) const {
+        std::vector<ClientInfo> out;
+        int64_t now = now_ns();
+        for (const Slot& slot : slots_) {
+            ClientInfo info;
+            if (read_slot(slot, info) && filter.matches(info, now)) out.push_back(info);
+        }
+        std::sort(out.begin(), out.end(), [](const ClientInfo& a, const ClientInfo& b) { return a.id < b.id; });
+        return out;
+    }
+
+    // Shuts down every client matching `filter` except the caller's own
+    // connection; the owning worker then sees EOF or a send error.
+    // Returns how many were killed.
+    size_t kill(const ClientFilter& filter) {
+        size_t killed = 0;
+        int64_t now = now_ns();
+        for (Slot& slot : slots_) {
+            if (&slot == current_) continue;
+            ClientInfo info;
+            if (!read_slot(slot, info) || !filter.matches(info, now)) continue;
+
+            std::lock_guard<std::mutex> lock(slot.life);
+            ClientInfo again;
+            int fd = slot.fd.load(std::memory_order_relaxed);
+            if (fd < 0 || !read_slot(slot, again) || again.id != info.id) continue; // Closed meanwhile
+            shutdown(fd, SHUT_RDWR);
+            ++killed;
+        }
+        return killed;
+    }
+
+    uint64_t untracked() const { return untracked_.load(std::memory_order_relaxed); }
+
+    // CLIENT LIST text, one line per client
+    std::string format_list(const ClientFilter& filter = {}) const {
+        std::string out;
+        char line[512];
+        int64_t now = now_ns();
+        for (const ClientInfo& c : list(filter)) {
+            std::snprintf(line, sizeof(line),
+                "id=%llu addr=%s fd=%d age=%lld idle=%lld worker=%d qbuf=%lld obuf=%lld "
+                "tot-net-in=%llu tot-net-out=%llu cmd=%s path=%s\n",
+                static_cast<unsigned long long>(c.id), c.addr, c.fd,
+                static_cast<long long>((now - c.created_ns) / 1000000000),
+                static_cast<long long>((now - c.last_active_ns) / 1000000000), c.worker,
+                static_cast<long long>(c.qbuf), static_cast<long long>(c.obuf),
+                static_cast<unsigned long long>(c.bytes_in), static_cast<unsigned long long>(c.bytes_out),
+                c.cmd[0] ? c.cmd : "NULL", c.path);
+            out += line;
+        }
+        return out;
+    }
+
+    // INFO-style "clients" section
+    std::string info_section() const {
+        std::vector<ClientInfo> clients = list();
+        int64_t max_qbuf = 0, max_obuf = 0;
+        for (const ClientInfo& c : clients) {
+            max_qbuf = std::max(max_qbuf, c.qbuf);
+            max_obuf = std::max(max_obuf, c.obuf);
+        }
+        std::string out = "# Clients\r\n";
+        out += "connected_clients:" + std::to_string(clients.size()) + "\r\n";
+        out += "client_recent_max_input_buffer:" + std::to_string(max_qbuf) + "\r\n";
+        out += "client_recent_max_output_buffer:" + std::to_string(max_obuf) + "\r\n";
+        out += "clients_untracked:" + std::to_string(untracked()) + "\r\n";
+        return out;
+    }
+
+    ClientRegistry(const ClientRegistry&) = delete;
+    ClientRegistry& operator=(const ClientRegistry&) = delete;
+
+private:
+    Slot slots_[CAPACITY];
+    std::atomic<size_t> hint_{0};
+    std::atomic<uint64_t> next_id_{1};
+    std::atomic<uint64_t> untracked_{0};
+
+    static inline thread_local Slot* current_ = nullptr;
+
+    ClientRegistry() = default;
+
+    // Single writer per slot, so a load and a store are enough
+    template <typename T, typename D>
+    static void bump(std::atomic<T>& counter, D delta) {
+        counter.store(counter.load(std::memory_order_relaxed) + static_cast<T>(delta), std::memory_order_relaxed);
+    }
+
+    template <typename Fn>
+    static void write_info(Slot& slot, Fn&& fn) {
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        slot.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        fn(slot.info);
+        slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    static bool read_slot(const Slot& slot, ClientInfo& out) {
+        if (!slot.in_use.load(std::memory_order_acquire)) return false;
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        std::memcpy(&out, &slot.info, sizeof(out));
+        out.fd = slot.fd.load(std::memory_order_relaxed);
+        out.worker = slot.worker.load(std::memory_order_relaxed);
+        out.last_active_ns = slot.last_active_ns.load(std::memory_order_relaxed);
+        out.bytes_in = slot.bytes_in.load(std::memory_order_relaxed);
+        out.bytes_out = slot.bytes_out.load(std::memory_order_relaxed);
+        out.qbuf = slot.qbuf.load(std::memory_order_relaxed);
+        out.obuf = slot.obuf.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return out.id != 0 && out.fd >= 0 && slot.seq.load(std::memory_order_relaxed) == before;
+    }
+
+    static void copy_truncated(char* dst, size_t cap, const std::string& src) {
+        size_t n = std::min(src.size(), cap - 1);
+        std::memcpy(dst, src.data(), n);
+        dst[n] = '\0';
+    }
+};
+
+} // namespace stats
@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace stats {
+
+// Fixed-memory log-linear histogram in the style of HdrHistogram.
+//
+// Values below 2 * SUB_BUCKETS land in exact buckets. Above that, every
+// power of two is split into SUB_BUCKETS linear buckets, so a recorded
+// value is off by at most 1 / SUB_BUCKETS (about 3%). Values at or above
+// 2^MAX_BITS are clamped into the last bucket; max() is still exact.
+class LogLinearHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ull << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;  // ~18 minutes in nanoseconds
+    static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucket_of(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) return static_cast<size_t>(value);
+        value = std::min<uint64_t>(value, (1ull << MAX_BITS) - 1);
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Largest value that maps to `bucket`
+    static uint64_t bucket_upper(size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) return bucket;
+        unsigned shift = static_cast<unsigned>(bucket / SUB_BUCKETS) - 1;
+        uint64_t mantissa = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    // Single writer: only the owning thread records, readers merge()
+    void record(uint64_t value) {
+        bump(counts_[bucket_of(value)], 1);
+        bump(count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Plain (non-atomic) copy used for merging shards and computing percentiles
+    struct Snapshot {
+        std::array<uint64_t, BUCKETS> counts{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        // Value at quantile q in [0, 1], reported as its bucket's upper bound
+        uint64_t percentile(double q) const {
+            if (count == 0) return 0;
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+            rank = std::clamp<uint64_t>(rank, 1, count);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                seen += counts[i];
+                if (seen >= rank) return std::min(bucket_upper(i), max);
+            }
+            return max;
+        }
+    };
+
+    void merge_into(Snapshot& out) const {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            out.counts[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+        out.count += count_.load(std::memory_order_relaxed);
+        out.sum += sum_.load(std::memory_order_relaxed);
+        out.max = std::max(out.max, max_.load(std::memory_order_relaxed));
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_ = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+
+    static void bump(std::atomic<uint64_t>& slot, uint64_t delta) {
+        slot.store(slot.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+};
+
+} // namespace stats
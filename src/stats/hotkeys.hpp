@@ -0,0 +1,251 @@
+#pragma once
+#include "thread_counters.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace stats {
+
+// Hot key detection (HOTKEYS), cheap enough to leave on.
+//
+// Every worker keeps its own shard: a count-min sketch of key accesses
+// plus the TOP_K keys with the highest estimates. The sketch uses
+// conservative update (only the smallest counters grow), which keeps
+// overestimates down. Sketch and top-K are halved every DECAY_PERIOD, so
+// the counts follow recent traffic instead of all-time totals.
+//
+// The owning thread updates sketch counters with relaxed stores. It is
+// also the only writer of its top-K, and readers only look at the keys,
+// so a hit on a key already in the top-K just bumps that entry's count
+// without the lock and leaves the heap order stale. The shard mutex is
+// taken, and the heap repaired, only when a key has to join the top-K.
+// The stale top_min is then a lower bound (counts only grow between
+// decays), which can send a few extra candidates to the locked path but
+// never turns one away. A HOTKEYS read takes the union of every shard's top-K as candidates and
+// sums each candidate's sketch estimate over all shards. A key split
+// across workers is therefore counted in full even where it missed a
+// shard's top-K. Shards that have not decayed recently, such as idle
+// workers, are scaled down at read time.
+struct alignas(64) HotKeyShard {
+    static constexpr size_t DEPTH = 4;
+    static constexpr size_t WIDTH = 2048;
+    static constexpr size_t TOP_K = 32;
+    static constexpr size_t KEY_LEN = 128;
+
+    struct Entry {
+        std::string key;
+        uint64_t hash;
+        uint64_t count; // Written by the owner without the lock; readers never look at it
+    };
+
+    std::atomic<uint32_t> sketch[DEPTH][WIDTH] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<int64_t> decayed_at_ns{0};
+    std::atomic<uint64_t> generation{0}; // Matches hotkeys_generation unless a reset is pending
+
+    std::mutex top_mutex;              // Held by the owner while changing `top`, and by readers
+    std::vector<Entry> top;            // Min-heap on count, unless heap_stale
+    bool heap_stale = false;           // Owner only: counts grew since the last heapify
+    std::atomic<uint64_t> top_min{0};  // Lower bound on the smallest count in a full top-K, 0 while it has room
+};
+
+using ThreadHotKeys = ThreadShards<HotKeyShard>;
+
+constexpr int64_t HOTKEY_DECAY_PERIOD_NS = 5'000'000'000; // Counts halve every 5s
+
+// Bumped by reset_hotkeys(); shards clear themselves when they notice
+inline std::atomic<uint64_t> hotkeys_generation{1};
+
+namespace detail {
+
+inline int64_t hotkey_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t hotkey_hash(std::string_view key) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Column of `hash` in sketch row `row`, by double hashing
+inline size_t hotkey_column(uint64_t hash, size_t row) {
+    uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+    return static_cast<size_t>((h1 + row * h2) % HotKeyShard::WIDTH);
+}
+
+// Halvings still owed by `shard` at `now`
+inline unsigned pending_decay(const HotKeyShard& shard, int64_t now) {
+    int64_t elapsed = now - shard.decayed_at_ns.load(std::memory_order_relaxed);
+    int64_t periods = elapsed > 0 ? elapsed / HOTKEY_DECAY_PERIOD_NS : 0;
+    return static_cast<unsigned>(std::min<int64_t>(periods, 63));
+}
+
+inline uint64_t sketch_estimate(const HotKeyShard& shard, uint64_t hash) {
+    uint64_t est = UINT64_MAX;
+    for (size_t row = 0; row < HotKeyShard::DEPTH; ++row) {
+        est = std::min<uint64_t>(est, shard.sketch[row][hotkey_column(hash, row)].load(std::memory_order_relaxed));
+    }
+    return est;
+}
+
+// Owner only: applies owed halvings, or clears the shard after a reset
+inline void hotkey_maintain(HotKeyShard& shard, int64_t now) {
+    uint64_t generation = hotkeys_generation.load(std::memory_order_relaxed);
+    bool reset = shard.generation.load(std::memory_order_relaxed) != generation;
+    unsigned shift = reset ? 32 : pending_decay(shard, now);
+    if (shift == 0) return;
+
+    for (auto& row : shard.sketch) {
+        for (auto& counter : row) {
+            uint32_t value = counter.load(std::memory_order_relaxed);
+            if (value) counter.store(shift >= 32 ? 0 : value >> shift, std::memory_order_relaxed);
+        }
+    }
+    uint64_t total = shard.total.load(std::memory_order_relaxed);
+    shard.total.store(shift >= 64 ? 0 : total >> shift, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(shard.top_mutex);
+        if (reset) shard.top.clear();
+        for (auto& e : shard.top) e.count = shift >= 64 ? 0 : e.count >> shift;
+        shard.top.erase(std::remove_if(shard.top.begin(), shard.top.end(),
+                                       [](const HotKeyShard::Entry& e) { return e.count == 0; }),
+                        shard.top.end());
+        std::make_heap(shard.top.begin(), shard.top.end(),
+                       [](const HotKeyShard::Entry& a, const HotKeyShard::Entry& b) { return a.count > b.count; });
+        shard.heap_stale = false;
+        shard.top_min.store(shard.top.size() < HotKeyShard::TOP_K ? 0 : shard.top.front().count,
+                            std::memory_order_relaxed);
+    }
+    if (reset) {
+        shard.decayed_at_ns.store(now, std::memory_order_relaxed);
+        shard.generation.store(generation, std::memory_order_relaxed);
+    } else {
+        shard.decayed_at_ns.store(shard.decayed_at_ns.load(std::memory_order_relaxed) +
+                                  static_cast<int64_t>(shift) * HOTKEY_DECAY_PERIOD_NS, std::memory_order_relaxed);
+    }
+}
+
+} // namespace detail
+
+// Counts one access to `key` on the calling thread's shard
+inline void record_key_access(std::string_view key) {
+    if (key.size() > HotKeyShard::KEY_LEN) key = key.substr(0, HotKeyShard::KEY_LEN);
+    HotKeyShard& shard = ThreadHotKeys::instance().local();
+    int64_t now = detail::hotkey_now_ns();
+    if (shard.decayed_at_ns.load(std::memory_order_relaxed) == 0) {
+        shard.decayed_at_ns.store(now, std::memory_order_relaxed);
+        shard.generation.store(hotkeys_generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    detail::hotkey_maintain(shard, now);
+
+    // Conservative update: raise only the counters below the new estimate
+    uint64_t hash = detail::hotkey_hash(key);
+    uint64_t updated = detail::sketch_estimate(shard, hash) + 1;
+    if (updated > UINT32_MAX) updated = UINT32_MAX;
+    for (size_t row = 0; row < HotKeyShard::DEPTH; ++row) {
+        auto& counter = shard.sketch[row][detail::hotkey_column(hash, row)];
+        if (counter.load(std::memory_order_relaxed) < updated) {
+            counter.store(static_cast<uint32_t>(updated), std::memory_order_relaxed);
+        }
+    }
+    shard.total.store(shard.total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (updated <= shard.top_min.load(std::memory_order_relaxed)) return; // Not a top-K candidate
+
+    // Already a member: refresh its count in place, no lock and no heap work
+    for (auto& e : shard.top) {
+        if (e.hash == hash && e.key == key) {
+            e.count = updated;
+            shard.heap_stale = true;
+            return;
+        }
+    }
+
+    auto heap_order = [](const HotKeyShard::Entry& a, const HotKeyShard::Entry& b) { return a.count > b.count; };
+    std::lock_guard<std::mutex> lock(shard.top_mutex);
+    if (shard.heap_stale) {
+        std::make_heap(shard.top.begin(), shard.top.end(), heap_order);
+        shard.heap_stale = false;
+    }
+    if (shard.top.size() < HotKeyShard::TOP_K) {
+        shard.top.push_back({std::string(key), hash, updated});
+        std::push_heap(shard.top.begin(), shard.top.end(), heap_order);
+    } else if (updated > shard.top.front().count) {
+        std::pop_heap(shard.top.begin(), shard.top.end(), heap_order);
+        shard.top.back() = {std::string(key), hash, updated};
+        std::push_heap(shard.top.begin(), shard.top.end(), heap_order);
+    }
+    shard.top_min.store(shard.top.size() < HotKeyShard::TOP_K ? 0 : shard.top.front().count,
+                        std::memory_order_relaxed);
+}
+
+struct HotKey {
+    std::string key;
+    uint64_t count; // Decayed access estimate
+};
+
+// Hottest keys over every shard, highest first. `total` receives the
+// decayed number of accesses, for computing each key's share.
+inline std::vector<HotKey> hotkeys(size_t count, uint64_t* total = nullptr) {
+    int64_t now = detail::hotkey_now_ns();
+    uint64_t generation = hotkeys_generation.load(std::memory_order_relaxed);
+
+    std::vector<std::string> candidates;
+    std::vector<std::pair<const HotKeyShard*, unsigned>> shards; // Live shards and their owed halvings
+    uint64_t accesses = 0;
+    ThreadHotKeys::instance().for_each([&](const HotKeyShard& shard) {
+        if (shard.generation.load(std::memory_order_relaxed) != generation) return; // Reset since
+        unsigned shift = detail::pending_decay(shard, now);
+        shards.emplace_back(&shard, shift);
+        uint64_t shard_total = shard.total.load(std::memory_order_relaxed);
+        accesses += shift >= 64 ? 0 : shard_total >> shift;
+        std::lock_guard<std::mutex> lock(const_cast<HotKeyShard&>(shard).top_mutex);
+        for (const auto& e : shard.top) candidates.push_back(e.key);
+    });
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<HotKey> out;
+    for (const std::string& key : candidates) {
+        uint64_t hash = detail::hotkey_hash(key), sum = 0;
+        for (const auto& [shard, shift] : shards) {
+            uint64_t est = detail::sketch_estimate(*shard, hash);
+            sum += shift >= 64 ? 0 : est >> shift;
+        }
+        if (sum) out.push_back({key, sum});
+    }
+    std::sort(out.begin(), out.end(), [](const HotKey& a, const HotKey& b) {
+        return a.count != b.count ? a.count > b.count : a.key < b.key;
+    });
+    if (out.size() > count) out.resize(count);
+    if (total) *total = accesses;
+    return out;
+}
+
+inline void reset_hotkeys() { hotkeys_generation.fetch_add(1, std::memory_order_relaxed); }
+
+// HOTKEYS text, one line per key, highest first
+inline std::string format_hotkeys(size_t count) {
+    uint64_t total = 0;
+    std::string out;
+    char line[256];
+    for (const HotKey& k : hotkeys(count, &total)) {
+        std::snprintf(line, sizeof(line), "key=%s count=%llu share=%.2f%%\n", k.key.c_str(),
+                      static_cast<unsigned long long>(k.count), total ? 100.0 * k.count / total : 0.0);
+        out += line;
+    }
+    return out;
+}
+
+} // namespace stats
@@ -0,0 +1,180 @@
+#pragma once
+#include "latency.hpp"
+#include "perf_counters.hpp"
+#include "thread_counters.hpp"
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+namespace stats {
+
+// Hardware counters per route and per phase, from sampled requests.
+//
+// One request in hw_sample_rate has the worker thread's counter group read
+// at the start, after parsing and after the handler. The differences are
+// added to the worker's shard under the route the request ended up on, so
+// the parse cost is attributed per route as well. Wall-clock histograms
+// say a route is slow; these say whether it is stalled on cache misses,
+// branch mispredictions or simply executing a lot of instructions.
+enum HwPhase {
+    HW_PARSE,
+    HW_HANDLE,
+
+    HW_PHASE_COUNT
+};
+
+inline const char* hw_phase_name(HwPhase phase) {
+    switch (phase) {
+        case HW_PARSE: return "parse";
+        case HW_HANDLE: return "handle";
+        default: return "unknown";
+    }
+}
+
+// Sample one request in N; 0 turns sampling off
+inline std::atomic<uint32_t> hw_sample_rate{100};
+
+struct alignas(64) HwShard {
+    std::atomic<uint64_t> samples[TIMER_COUNT][HW_PHASE_COUNT] = {};
+    std::atomic<uint64_t> events[TIMER_COUNT][HW_PHASE_COUNT][PerfCounters::EVENT_COUNT] = {};
+};
+
+using ThreadHwCounters = ThreadShards<HwShard>;
+
+// The calling thread's counter group, opened on first use
+inline PerfCounters& thread_perf_counters() {
+    thread_local PerfCounters counters;
+    return counters;
+}
+
+// Counters around one request. Does nothing unless the request is sampled
+// and the kernel lets us open the counters.
+class HwSample {
+    bool active_ = false;
+    int marked_ = 0; // Phases completed so far
+    PerfCounters::Reading marks_[HW_PHASE_COUNT + 1];
+
+    static bool should_sample() {
+        uint32_t rate = hw_sample_rate.load(std::memory_order_relaxed);
+        if (rate == 0) return false;
+        thread_local uint32_t countdown = 0;
+        if (countdown > rate) countdown = rate; // Rate was lowered since the last sample
+        if (countdown > 0 && --countdown > 0) return false;
+        countdown = rate;
+        return true;
+    }
+
+public:
+    HwSample() {
+        if (!should_sample()) return;
+        active_ = thread_perf_counters().read(marks_[0]);
+    }
+
+    // Phases must be marked in order. A failed read drops the whole sample.
+    void mark(HwPhase phase) {
+        if (!active_ || phase != marked_) return;
+        active_ = thread_perf_counters().read(marks_[++marked_]);
+    }
+
+    // Adds the marked phases to `route`
+    void commit(Timer route) {
+        if (!active_) return;
+        active_ = false;
+        HwShard& shard = ThreadHwCounters::instance().local();
+        for (int p = 0; p < marked_; ++p) {
+            auto delta = PerfCounters::diff(marks_[p + 1], marks_[p]);
+            auto& samples = shard.samples[route][p];
+            samples.store(samples.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e) {
+                auto& slot = shard.events[route][p][e];
+                slot.store(slot.load(std::memory_order_relaxed) + delta[e], std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+// Every thread's shard summed
+struct HwTotals {
+    uint64_t samples[TIMER_COUNT][HW_PHASE_COUNT] = {};
+    uint64_t events[TIMER_COUNT][HW_PHASE_COUNT][PerfCounters::EVENT_COUNT] = {};
+};
+
+inline HwTotals hw_totals() {
+    HwTotals totals;
+    ThreadHwCounters::instance().for_each([&](const HwShard& shard) {
+        for (size_t t = 0; t < TIMER_COUNT; ++t) {
+            for (size_t p = 0; p < HW_PHASE_COUNT; ++p) {
+                totals.samples[t][p] += shard.samples[t][p].load(std::memory_order_relaxed);
+                for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e) {
+                    totals.events[t][p][e] += shard.events[t][p][e].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    return totals;
+}
+
+// INFO-style "hwstats" section: per route and phase, IPC and events per op
+inline std::string hw_info() {
+    std::string out = "# Hwstats\r\n";
+    out += "hwstats_available:" + std::to_string(thread_perf_counters().available() ? 1 : 0) + "\r\n";
+    out += "hwstats_sample_rate:" + std::to_string(hw_sample_rate.load()) + "\r\n";
+
+    HwTotals totals = hw_totals();
+    char line[320];
+    for (size_t t = 0; t < TIMER_COUNT; ++t) {
+        for (size_t p = 0; p < HW_PHASE_COUNT; ++p) {
+            uint64_t n = totals.samples[t][p];
+            if (n == 0) continue;
+            const uint64_t* ev = totals.events[t][p];
+            double cycles = static_cast<double>(ev[PerfCounters::CYCLES]);
+            std::snprintf(line, sizeof(line),
+                "hwstat_%s_%s:samples=%llu,ipc=%.2f,instructions_per_op=%.1f,cycles_per_op=%.1f,"
+                "cache_misses_per_op=%.2f,branch_misses_per_op=%.2f\r\n",
+                timer_name(static_cast<Timer>(t)), hw_phase_name(static_cast<HwPhase>(p)),
+                static_cast<unsigned long long>(n),
+                cycles > 0 ? ev[PerfCounters::INSTRUCTIONS] / cycles : 0.0,
+                static_cast<double>(ev[PerfCounters::INSTRUCTIONS]) / n, cycles / n,
+                static_cast<double>(ev[PerfCounters::CACHE_MISSES]) / n,
+                static_cast<double>(ev[PerfCounters::BRANCH_MISSES]) / n);
+            out += line;
+        }
+    }
+    return out;
+}
+
+// Prometheus counters; rate() of events over samples gives the per-op figures
+inline std::string hw_prometheus_text() {
+    std::string out =
+        "# HELP tcpserver_hw_samples_total Requests sampled for hardware counters.\n"
+        "# TYPE tcpserver_hw_samples_total counter\n";
+    HwTotals totals = hw_totals();
+    char line[256];
+    for (size_t t = 0; t < TIMER_COUNT; ++t) {
+        for (size_t p = 0; p < HW_PHASE_COUNT; ++p) {
+            if (totals.samples[t][p] == 0) continue;
+            std::snprintf(line, sizeof(line), "tcpserver_hw_samples_total{route=\"%s\",phase=\"%s\"} %llu\n",
+                timer_name(static_cast<Timer>(t)), hw_phase_name(static_cast<HwPhase>(p)),
+                static_cast<unsigned long long>(totals.samples[t][p]));
+            out += line;
+        }
+    }
+    out += "# HELP tcpserver_hw_events_total Hardware events counted in sampled requests.\n"
+           "# TYPE tcpserver_hw_events_total counter\n";
+    for (size_t t = 0; t < TIMER_COUNT; ++t) {
+        for (size_t p = 0; p < HW_PHASE_COUNT; ++p) {
+            if (totals.samples[t][p] == 0) continue;
+            for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e) {
+                std::snprintf(line, sizeof(line),
+                    "tcpserver_hw_events_total{route=\"%s\",phase=\"%s\",event=\"%s\"} %llu\n",
+                    timer_name(static_cast<Timer>(t)), hw_phase_name(static_cast<HwPhase>(p)),
+                    PerfCounters::event_name(static_cast<PerfCounters::Event>(e)),
+                    static_cast<unsigned long long>(totals.events[t][p][e]));
+                out += line;
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace stats
@@ -0,0 +1,115 @@
+#pragma once
+#include "histogram.hpp"
+#include "thread_counters.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace stats {
+
+// Latencies tracked per thread. Add new entries before TIMER_COUNT.
+enum Timer : size_t {
+    // From accept() to a worker taking the FD out of client_queue
+    QUEUE_WAIT,
+    // Service time per route: parse, handle and send
+    ROUTE_ECHO,
+    ROUTE_INFO,
+    ROUTE_METRICS,
+    ROUTE_SLOWLOG,
+    ROUTE_LATENCY,
+    ROUTE_TRACE,
+    ROUTE_LOGLEVEL,
+    ROUTE_CLIENT,
+    ROUTE_PROFILE,
+    ROUTE_HWSTATS,
+    ROUTE_HOTKEYS,
+
+    TIMER_COUNT
+};
+
+inline const char* timer_name(Timer timer) {
+    switch (timer) {
+        case QUEUE_WAIT: return "queue_wait";
+        case ROUTE_ECHO: return "echo";
+        case ROUTE_INFO: return "info";
+        case ROUTE_METRICS: return "metrics";
+        case ROUTE_SLOWLOG: return "slowlog";
+        case ROUTE_LATENCY: return "latency";
+        case ROUTE_TRACE: return "trace";
+        case ROUTE_LOGLEVEL: return "loglevel";
+        case ROUTE_CLIENT: return "client";
+        case ROUTE_PROFILE: return "profile";
+        case ROUTE_HWSTATS: return "hwstats";
+        case ROUTE_HOTKEYS: return "hotkeys";
+        default: return "unknown";
+    }
+}
+
+struct alignas(64) LatencyShard {
+    LogLinearHistogram timers[TIMER_COUNT];
+};
+
+using ThreadLatencies = ThreadShards<LatencyShard>;
+
+inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point since,
+                           std::chrono::steady_clock::time_point until = std::chrono::steady_clock::now()) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(until - since).count();
+    return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+}
+
+inline void record_latency(Timer timer, uint64_t ns) {
+    ThreadLatencies::instance().local().timers[timer].record(ns);
+}
+
+// Merges every thread's histogram for `timer`
+inline LogLinearHistogram::Snapshot latency_snapshot(Timer timer) {
+    LogLinearHistogram::Snapshot snapshot;
+    ThreadLatencies::instance().for_each([&](const LatencyShard& shard) {
+        shard.timers[timer].merge_into(snapshot);
+    });
+    return snapshot;
+}
+
+// INFO-style "latencystats" section, in microseconds
+inline std::string latency_info() {
+    std::string out = "# Latencystats\r\n";
+    char line[256];
+    for (size_t t = 0; t < TIMER_COUNT; ++t) {
+        auto snap = latency_snapshot(static_cast<Timer>(t));
+        if (snap.count == 0) continue;
+        std::snprintf(line, sizeof(line),
+            "latency_percentiles_usec_%s:p50=%.3f,p99=%.3f,p99.9=%.3f,max=%.3f,calls=%llu\r\n",
+            timer_name(static_cast<Timer>(t)),
+            snap.percentile(0.50) / 1e3, snap.percentile(0.99) / 1e3,
+            snap.percentile(0.999) / 1e3, snap.max / 1e3,
+            static_cast<unsigned long long>(snap.count));
+        out += line;
+    }
+    return out;
+}
+
+// Prometheus summary, in seconds
+inline std::string latency_prometheus_text() {
+    std::string out =
+        "# HELP tcpserver_latency_seconds Request service and queue-wait latency.\n"
+        "# TYPE tcpserver_latency_seconds summary\n";
+    char line[256];
+    for (size_t t = 0; t < TIMER_COUNT; ++t) {
+        auto snap = latency_snapshot(static_cast<Timer>(t));
+        const char* name = timer_name(static_cast<Timer>(t));
+        for (double q : {0.5, 0.99, 0.999, 1.0}) {
+            uint64_t ns = q < 1.0 ? snap.percentile(q) : snap.max;
+            std::snprintf(line, sizeof(line),
+                "tcpserver_latency_seconds{timer=\"%s\",quantile=\"%g\"} %.9f\n", name, q, ns / 1e9);
+            out += line;
+        }
+        std::snprintf(line, sizeof(line),
+            "tcpserver_latency_seconds_sum{timer=\"%s\"} %.9f\n"
+            "tcpserver_latency_seconds_count{timer=\"%s\"} %llu\n",
+            name, snap.sum / 1e9, name, static_cast<unsigned long long>(snap.count));
+        out += line;
+    }
+    return out;
+}
+
+} // namespace stats
@@ -0,0 +1,180 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+namespace stats {
+
+// Internal operations that can stall a thread. Add new entries before EVENT_COUNT.
+enum LatencyEvent : size_t {
+    EVENT_ACCEPT_ERROR,  // Time spent in an accept() call that failed
+    EVENT_MALLOC_TRIM,   // MemoryReclaimer handing pages back to the OS
+    EVENT_LARGE_FREE,    // Releasing a large request or response buffer
+
+    EVENT_COUNT
+};
+
+inline const char* latency_event_name(LatencyEvent event) {
+    switch (event) {
+        case EVENT_ACCEPT_ERROR: return "accept-error";
+        case EVENT_MALLOC_TRIM: return "malloc-trim";
+        case EVENT_LARGE_FREE: return "large-free";
+        default: return "unknown";
+    }
+}
+
+// Worst and most recent stall per event type, with a short per-second history.
+//
+// Only events at or above the threshold are kept, so the mutex is taken
+// rarely; the fast path is a single relaxed load.
+class LatencyMonitor {
+public:
+    static constexpr size_t HISTORY_LEN = 160;
+
+    struct Sample {
+        int64_t time = 0;         // Unix seconds
+        uint64_t latency_us = 0;  // Worst stall seen during that second
+    };
+
+    static LatencyMonitor& instance() {
+        static LatencyMonitor monitor;
+        return monitor;
+    }
+
+    // Stalls shorter than this are ignored; negative disables the monitor
+    void set_threshold_us(int64_t us) { threshold_us_.store(us, std::memory_order_relaxed); }
+    int64_t threshold_us() const { return threshold_us_.load(std::memory_order_relaxed); }
+
+    void record(LatencyEvent event, uint64_t latency_us) {
+        int64_t threshold = threshold_us();
+        if (threshold < 0 || latency_us < static_cast<uint64_t>(threshold)) return;
+
+        int64_t now = static_cast<int64_t>(std::time(nullptr));
+        std::lock_guard<std::mutex> lock(mutex_);
+        Series& s = series_[event];
+        s.max_us = std::max(s.max_us, latency_us);
+        s.total_us += latency_us;
+        s.events++;
+
+        if (s.len > 0) {
+            Sample& last = s.samples[(s.next + HISTORY_LEN - 1) % HISTORY_LEN];
+            if (last.time == now) { // Same second: keep the worst one
+                last.latency_us = std::max(last.latency_us, latency_us);
+                return;
+            }
+        }
+        s.samples[s.next] = Sample{now, latency_us};
+        s.next = (s.next + 1) % HISTORY_LEN;
+        s.len = std::min(s.len + 1, HISTORY_LEN);
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& s : series_) s = Series{};
+    }
+
+    // LATENCY LATEST: event, time of latest sample, latest and all-time max
+    std::string latest() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        char line[256];
+        for (size_t e = 0; e < EVENT_COUNT; ++e) {
+            const Series& s = series_[e];
+            if (s.len == 0) continue;
+            const Sample& last = s.samples[(s.next + HISTORY_LEN - 1) % HISTORY_LEN];
+            std::snprintf(line, sizeof(line), "%s time=%lld latest_us=%llu max_us=%llu\n",
+                latency_event_name(static_cast<LatencyEvent>(e)), static_cast<long long>(last.time),
+                static_cast<unsigned long long>(last.latency_us), static_cast<unsigned long long>(s.max_us));
+            out += line;
+        }
+        return out;
+    }
+
+    // LATENCY HISTORY <event>: oldest sample first. Returns false for unknown events.
+    bool history(const std::string& event_name, std::string& out) const {
+        size_t e = find_event(event_name);
+        if (e == EVENT_COUNT) return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        const Series& s = series_[e];
+        char line[64];
+        for (size_t i = 0; i < s.len; ++i) {
+            const Sample& sample = s.samples[(s.next + HISTORY_LEN - s.len + i) % HISTORY_LEN];
+            std::snprintf(line, sizeof(line), "%lld %llu\n", static_cast<long long>(sample.time),
+                          static_cast<unsigned long long>(sample.latency_us));
+            out += line;
+        }
+        return true;
+    }
+
+    // LATENCY DOCTOR: a short human-readable report with hints per event
+    std::string doctor() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::string out;
+        char line[256];
+        int64_t threshold = threshold_us();
+        if (threshold < 0) {
+            return "Latency monitoring is disabled. Enable it with /latency/config?threshold-us=<usec>.\n";
+        }
+
+        size_t n = 0;
+        for (size_t e = 0; e < EVENT_COUNT; ++e) {
+            const Series& s = series_[e];
+            if (s.events == 0) continue;
+            std::snprintf(line, sizeof(line),
+                "%zu. %s: %llu stalls above %lld us, average %llu us, worst %llu us.\n   %s\n",
+                ++n, latency_event_name(static_cast<LatencyEvent>(e)),
+                static_cast<unsigned long long>(s.events), static_cast<long long>(threshold),
+                static_cast<unsigned long long>(s.total_us / s.events),
+                static_cast<unsigned long long>(s.max_us), advice(static_cast<LatencyEvent>(e)));
+            out += line;
+        }
+        if (n == 0) {
+            return "No internal stalls above " + std::to_string(threshold) +
+                   " us were recorded. Slow requests are more likely network or client side.\n";
+        }
+        return out;
+    }
+
+    static size_t find_event(const std::string& name) {
+        for (size_t e = 0; e < EVENT_COUNT; ++e) {
+            if (name == latency_event_name(static_cast<LatencyEvent>(e))) return e;
+        }
+        return EVENT_COUNT;
+    }
+
+private:
+    struct Series {
+        Sample samples[HISTORY_LEN];
+        size_t next = 0;
+        size_t len = 0;
+        uint64_t max_us = 0;
+        uint64_t total_us = 0;
+        uint64_t events = 0;
+    };
+
+    mutable std::mutex mutex_;
+    Series series_[EVENT_COUNT];
+    std::atomic<int64_t> threshold_us_{1000};
+
+    LatencyMonitor() = default;
+
+    static const char* advice(LatencyEvent event) {
+        switch (event) {
+            case EVENT_ACCEPT_ERROR:
+                return "The accept loop backs off after each failure. Check the fd limit (EMFILE/ENFILE) and /metrics errors.";
+            case EVENT_MALLOC_TRIM:
+                return "Trimming a large heap is slow. It runs on idle workers only, but a big heap keeps it costly.";
+            case EVENT_LARGE_FREE:
+                return "Large request bodies are expensive to release. Consider lowering the accepted body size.";
+            default:
+                return "";
+        }
+    }
+};
+
+} // namespace stats
@@ -0,0 +1,69 @@
+#pragma once
+#include "thread_counters.hpp"
+#include "client_registry.hpp"
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>   // for mallinfo2
+#endif
+
+namespace stats {
+
+// Charges `bytes` to a memory gauge for as long as the object lives.
+class MemoryCharge {
+    Stat stat_;
+    size_t bytes_ = 0;
+
+public:
+    MemoryCharge(Stat stat, size_t bytes = 0) : stat_(stat) { resize(bytes); }
+    ~MemoryCharge() { resize(0); }
+
+    void resize(size_t bytes) {
+        int64_t delta = static_cast<int64_t>(bytes) - static_cast<int64_t>(bytes_);
+        add(stat_, delta);
+        ClientRegistry::on_buffer(stat_, delta); // Per-connection qbuf/obuf
+        bytes_ = bytes;
+    }
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+};
+
+// Resident set size of the whole process, from /proc/self/statm
+inline size_t process_rss_bytes() {
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long size = 0, resident = 0;
+    int matched = std::fscanf(f, "%lu %lu", &size, &resident);
+    std::fclose(f);
+    if (matched != 2) return 0;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// INFO-style "memory" section
+inline std::string memory_info() {
+    std::string out = "# Memory\r\n";
+    auto line = [&out](const char* key, int64_t value) {
+        out += key;
+        out += ":" + std::to_string(value) + "\r\n";
+    };
+
+    int64_t query_buf = get(MEM_CLIENT_QUERY_BUF);
+    int64_t output_buf = get(MEM_CLIENT_OUTPUT_BUF);
+    line("used_memory_clients_query", query_buf);
+    line("used_memory_clients_output", output_buf);
+    line("used_memory_clients", query_buf + output_buf);
+    line("used_memory_rss", static_cast<int64_t>(process_rss_bytes()));
+    line("allocator_trims", get(MEM_TRIMS));
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    line("allocator_allocated", static_cast<int64_t>(mi.uordblks + mi.hblkhd));
+    line("allocator_free", static_cast<int64_t>(mi.fordblks));
+    line("allocator_releasable", static_cast<int64_t>(mi.keepcost));
+#endif
+    return out;
+}
+
+} // namespace stats
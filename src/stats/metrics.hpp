@@ -0,0 +1,65 @@
+#pragma once
+#include "thread_counters.hpp"
+#include "memory_stats.hpp"
+#include "latency.hpp"
+#include "hw_counters.hpp"
+#include <algorithm>
+#include <string>
+
+namespace stats {
+
+// Prometheus text exposition (format 0.0.4) of every counter and gauge
+inline std::string prometheus_text() {
+    std::string out;
+    auto header = [&out](const char* name, const char* type, const char* help) {
+        out += std::string("# HELP ") + name + " " + help + "\n";
+        out += std::string("# TYPE ") + name + " " + type + "\n";
+    };
+    auto sample = [&out](const std::string& name, int64_t value) {
+        // Gauges are summed from per-thread deltas and can read briefly negative
+        out += name + " " + std::to_string(std::max<int64_t>(value, 0)) + "\n";
+    };
+    auto metric = [&](const char* name, const char* type, const char* help, Stat stat) {
+        header(name, type, help);
+        sample(name, get(stat));
+    };
+
+    metric("tcpserver_requests_total", "counter", "Requests parsed and handled.", REQUESTS_TOTAL);
+    metric("tcpserver_received_bytes_total", "counter", "Bytes read from client sockets.", BYTES_RECEIVED);
+    metric("tcpserver_sent_bytes_total", "counter", "Bytes written to client sockets.", BYTES_SENT);
+    metric("tcpserver_connections_accepted_total", "counter", "Connections accepted.", CONNECTIONS_ACCEPTED);
+    metric("tcpserver_connections", "gauge", "Connections currently open.", CONNECTIONS_ACTIVE);
+    metric("tcpserver_queue_depth", "gauge", "Accepted connections waiting for a worker.", QUEUE_DEPTH);
+
+    header("tcpserver_errors_total", "counter", "Errors by type.");
+    sample("tcpserver_errors_total{type=\"accept\"}", get(ERRORS_ACCEPT));
+    sample("tcpserver_errors_total{type=\"protocol\"}", get(ERRORS_PROTOCOL));
+    sample("tcpserver_errors_total{type=\"handler\"}", get(ERRORS_HANDLER));
+    sample("tcpserver_errors_total{type=\"send\"}", get(ERRORS_SEND));
+
+    header("tcpserver_route_calls_total", "counter", "Requests served per route.");
+    sample("tcpserver_route_calls_total{route=\"echo\"}", get(CALLS_ECHO));
+    sample("tcpserver_route_calls_total{route=\"/info\"}", get(CALLS_INFO));
+    sample("tcpserver_route_calls_total{route=\"/metrics\"}", get(CALLS_METRICS));
+    sample("tcpserver_route_calls_total{route=\"/slowlog\"}", get(CALLS_SLOWLOG));
+    sample("tcpserver_route_calls_total{route=\"/latency\"}", get(CALLS_LATENCY));
+    sample("tcpserver_route_calls_total{route=\"/trace\"}", get(CALLS_TRACE));
+    sample("tcpserver_route_calls_total{route=\"/loglevel\"}", get(CALLS_LOGLEVEL));
+    sample("tcpserver_route_calls_total{route=\"/clients\"}", get(CALLS_CLIENT));
+    sample("tcpserver_route_calls_total{route=\"/profile\"}", get(CALLS_PROFILE));
+    sample("tcpserver_route_calls_total{route=\"/hwstats\"}", get(CALLS_HWSTATS));
+    sample("tcpserver_route_calls_total{route=\"/hotkeys\"}", get(CALLS_HOTKEYS));
+
+    header("tcpserver_memory_clients_bytes", "gauge", "Bytes held in client buffers.");
+    sample("tcpserver_memory_clients_bytes{buffer=\"query\"}", get(MEM_CLIENT_QUERY_BUF));
+    sample("tcpserver_memory_clients_bytes{buffer=\"output\"}", get(MEM_CLIENT_OUTPUT_BUF));
+    header("tcpserver_memory_rss_bytes", "gauge", "Resident set size of the process.");
+    sample("tcpserver_memory_rss_bytes", static_cast<int64_t>(process_rss_bytes()));
+    metric("tcpserver_memory_trims_total", "counter", "Heap trims run by idle workers.", MEM_TRIMS);
+
+    out += latency_prometheus_text();
+    out += hw_prometheus_text();
+    return out;
+}
+
+} // namespace stats
@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace stats {
+
+// Hardware counters of the calling thread, read through perf_event_open.
+//
+// The events are opened as one group so they are scheduled together and
+// read with a single read(). Only user-space work is counted, which works
+// under the default perf_event_paranoid setting. When the kernel refuses
+// (containers, no PMU) available() is false and every read fails.
+//
+// With more groups than hardware counters the kernel multiplexes them, and
+// a group only counts while it is scheduled. Every reading therefore
+// carries the time the group was enabled and the time it actually ran, and
+// diff() scales the counts of an interval up by their ratio.
+class PerfCounters {
+public:
+    enum Event : size_t {
+        INSTRUCTIONS,
+        CYCLES,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+
+        EVENT_COUNT
+    };
+
+    using Values = std::array<uint64_t, EVENT_COUNT>;
+
+    // Running totals since construction; take two and diff() them
+    struct Reading {
+        Values counts{};
+        uint64_t time_enabled = 0; // ns
+        uint64_t time_running = 0; // ns, less than time_enabled when multiplexed
+    };
+
+    static const char* event_name(Event e) {
+        switch (e) {
+            case INSTRUCTIONS: return "instructions";
+            case CYCLES: return "cycles";
+            case CACHE_MISSES: return "cache_misses";
+            case BRANCH_MISSES: return "branch_misses";
+            default: return "unknown";
+        }
+    }
+
+    PerfCounters() {
+        static const uint64_t configs[EVENT_COUNT] = {
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+        };
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.disabled = i == 0 ? 1 : 0; // The leader starts the whole group
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int leader = i == 0 ? -1 : fds_[0];
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            if (fds_[i] < 0) {
+                close_all();
+                return;
+            }
+        }
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    ~PerfCounters() { close_all(); }
+
+    bool available() const { return fds_[0] >= 0; }
+
+    // False if the counters are unavailable or the read failed; callers
+    // drop the sample rather than diff against a zero reading
+    bool read(Reading& out) const {
+        if (!available()) return false;
+        struct {
+            uint64_t nr;
+            uint64_t time_enabled;
+            uint64_t time_running;
+            uint64_t values[EVENT_COUNT];
+        } data{};
+        if (::read(fds_[0], &data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) return false;
+        if (data.nr != EVENT_COUNT) return false;
+        for (size_t i = 0; i < EVENT_COUNT; ++i) out.counts[i] = data.values[i];
+        out.time_enabled = data.time_enabled;
+        out.time_running = data.time_running;
+        return true;
+    }
+
+    // Counts between two readings, scaled up to the whole interval when the
+    // group was only scheduled for part of it. Zeros if it never ran.
+    static Values diff(const Reading& after, const Reading& before) {
+        Values out{};
+        if (after.time_running <= before.time_running) return out;
+        uint64_t enabled = after.time_enabled - before.time_enabled;
+        uint64_t running = after.time_running - before.time_running;
+        double scale = running < enabled ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+        for (size_t i = 0; i < EVENT_COUNT; ++i) {
+            if (after.counts[i] < before.counts[i]) continue;
+            out[i] = static_cast<uint64_t>(static_cast<double>(after.counts[i] - before.counts[i]) * scale);
+        }
+        return out;
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+private:
+    int fds_[EVENT_COUNT] = {-1, -1, -1, -1};
+
+    void close_all() {
+        for (int& fd : fds_) {
+            if (fd >= 0) close(fd);
+            fd = -1;
+        }
+    }
+};
+
+} // namespace stats
@@ -0,0 +1,225 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace stats {
+
+// Built-in sampling CPU profiler producing folded stacks for flamegraphs.
+//
+// ITIMER_PROF delivers SIGPROF to whichever thread is burning CPU, at
+// `hz` per CPU-second, so idle threads cost nothing and busy ones are
+// sampled in proportion to their CPU time. The handler only walks the
+// stack with backtrace() (the unwinder reads .eh_frame, so frame
+// pointers are not required) into a slot claimed with one fetch_add;
+// it never allocates. Symbols are resolved afterwards with dladdr,
+// which needs the executable to export its symbols (ENABLE_EXPORTS in
+// CMake); frames it cannot name print as module+offset.
+//
+// One profile runs at a time and the caller blocks for its duration.
+class Profiler {
+public:
+    static constexpr int MAX_DEPTH = 32;
+    static constexpr size_t MAX_SAMPLES = 1 << 16;
+    static constexpr int MAX_SECONDS = 60;
+    static constexpr int MAX_HZ = 1000;
+
+    struct Result {
+        bool ok = false;
+        bool busy = false;    // Another profile was already running
+        std::string error;    // Why sampling could not start, if not ok and not busy
+        std::string folded;   // "frame;frame;... count" lines, root first
+        uint64_t samples = 0;
+        uint64_t dropped = 0; // Samples lost to a full buffer
+    };
+
+    // Samples every thread for `seconds` and returns the folded stacks.
+    // With `per_thread`, each stack is rooted at "comm/tid".
+    static Result run(int seconds, int hz, bool per_thread) {
+        Result result;
+        bool expected = false;
+        if (!busy_.compare_exchange_strong(expected, true)) {
+            result.busy = true;
+            return result;
+        }
+
+        seconds = std::clamp(seconds, 1, MAX_SECONDS);
+        hz = std::clamp(hz, 1, MAX_HZ);
+        size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+        size_t capacity = std::min(MAX_SAMPLES, static_cast<size_t>(hz) * seconds * cpus);
+
+        // backtrace() loads the unwinder on first use; do that outside the handler
+        void* warm[2];
+        backtrace(warm, 2);
+
+        std::unique_ptr<Sample[]> samples(new Sample[capacity]);
+        samples_ = samples.get();
+        capacity_ = capacity;
+        next_.store(0, std::memory_order_relaxed);
+        dropped_.store(0, std::memory_order_relaxed);
+
+        struct sigaction sa{}, old_sa{};
+        sa.sa_sigaction = on_signal;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGPROF, &sa, &old_sa) != 0) {
+            result.error = std::string("sigaction: ") + std::strerror(errno);
+            samples_ = nullptr;
+            busy_.store(false);
+            return result;
+        }
+        running_.store(true, std::memory_order_release);
+
+        // tv_usec must stay below one second, so hz=1 is {1, 0}
+        long period_us = 1000000L / hz;
+        itimerval timer{};
+        timer.it_interval.tv_sec = period_us / 1000000;
+        timer.it_interval.tv_usec = period_us % 1000000;
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+            result.error = std::string("setitimer: ") + std::strerror(errno);
+            running_.store(false, std::memory_order_release);
+            sigaction(SIGPROF, &old_sa, nullptr);
+            samples_ = nullptr;
+            busy_.store(false);
+            return result;
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+        itimerval off{};
+        setitimer(ITIMER_PROF, &off, nullptr);
+        // Store-then-load on both sides (see on_signal), so both need seq_cst:
+        // with release/acquire this load could see 0 while a handler that
+        // already counted itself in still sees running_ == true
+        running_.store(false, std::memory_order_seq_cst);
+        while (in_handler_.load(std::memory_order_seq_cst) > 0) std::this_thread::yield();
+        sigaction(SIGPROF, &old_sa, nullptr);
+
+        size_t taken = std::min(next_.load(std::memory_order_relaxed), capacity);
+        result.ok = true;
+        result.samples = taken;
+        result.dropped = dropped_.load(std::memory_order_relaxed);
+        result.folded = fold(samples.get(), taken, per_thread);
+
+        samples_ = nullptr;
+        busy_.store(false);
+        return result;
+    }
+
+private:
+    struct Sample {
+        pid_t tid;
+        int depth;
+        void* pcs[MAX_DEPTH];
+    };
+
+    // Frames of the handler itself and the kernel's signal trampoline
+    static constexpr int SKIP_FRAMES = 2;
+
+    static inline std::atomic<bool> busy_{false};
+    static inline std::atomic<bool> running_{false};
+    static inline std::atomic<int> in_handler_{0};
+    static inline std::atomic<size_t> next_{0};
+    static inline std::atomic<uint64_t> dropped_{0};
+    static inline Sample* samples_ = nullptr;
+    static inline size_t capacity_ = 0;
+
+    static void on_signal(int, siginfo_t*, void*) {
+        int saved_errno = errno;
+        in_handler_.fetch_add(1, std::memory_order_seq_cst);
+        if (running_.load(std::memory_order_seq_cst)) {
+            size_t i = next_.fetch_add(1, std::memory_order_relaxed);
+            if (i < capacity_) {
+                Sample& s = samples_[i];
+                s.tid = static_cast<pid_t>(syscall(SYS_gettid));
+                s.depth = backtrace(s.pcs, MAX_DEPTH);
+            } else {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        in_handler_.fetch_sub(1, std::memory_order_release);
+        errno = saved_errno;
+    }
+
+    static std::string symbolize(void* pc) {
+        Dl_info info{};
+        if (!dladdr(pc, &info) || !info.dli_fname) return "[unknown]";
+        if (info.dli_sname) {
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+            std::free(demangled);
+            return name;
+        }
+        std::string module = info.dli_fname;
+        module = module.substr(module.find_last_of('/') + 1);
+        char offset[32];
+        std::snprintf(offset, sizeof(offset), "+0x%lx", static_cast<unsigned long>(
+            reinterpret_cast<uintptr_t>(pc) - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+        return module + offset;
+    }
+
+    static std::string thread_label(pid_t tid) {
+        std::string comm = "thread";
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/self/task/%d/comm", static_cast<int>(tid));
+        if (FILE* f = std::fopen(path, "r")) {
+            char buf[32] = {};
+            if (std::fgets(buf, sizeof(buf), f)) {
+                comm = buf;
+                if (!comm.empty() && comm.back() == '\n') comm.pop_back();
+            }
+            std::fclose(f);
+        }
+        return comm + "/" + std::to_string(tid);
+    }
+
+    static std::string fold(const Sample* samples, size_t count, bool per_thread) {
+        std::unordered_map<void*, std::string> symbols;
+        std::unordered_map<pid_t, std::string> threads;
+        std::map<std::string, uint64_t> stacks;
+
+        for (size_t i = 0; i < count; ++i) {
+            const Sample& s = samples[i];
+            std::string stack;
+            if (per_thread) {
+                auto it = threads.find(s.tid);
+                if (it == threads.end()) it = threads.emplace(s.tid, thread_label(s.tid)).first;
+                stack = it->second;
+            }
+            // Root first; return addresses point past the call, so step back one byte
+            for (int f = s.depth - 1; f >= SKIP_FRAMES; --f) {
+                void* pc = f == SKIP_FRAMES ? s.pcs[f] : static_cast<char*>(s.pcs[f]) - 1;
+                auto it = symbols.find(pc);
+                if (it == symbols.end()) it = symbols.emplace(pc, symbolize(pc)).first;
+                if (!stack.empty()) stack += ';';
+                stack += it->second;
+            }
+            if (!stack.empty()) stacks[stack]++;
+        }
+
+        std::string out;
+        for (const auto& [stack, n] : stacks) out += stack + " " + std::to_string(n) + "\n";
+        return out;
+    }
+};
+
+} // namespace stats
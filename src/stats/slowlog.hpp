@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace stats {
+
+// Phase timestamps of one request, taken by handle_connection
+struct RequestTimings {
+    using time_point = std::chrono::steady_clock::time_point;
+    time_point started;   // Handler picked up the connection
+    time_point parsed;    // Request fully read and parsed
+    time_point executed;  // Response built
+    time_point sent;      // Response written to the socket
+
+    static uint64_t ns(time_point from, time_point to) {
+        auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+        return d > 0 ? static_cast<uint64_t>(d) : 0;
+    }
+    uint64_t total_ns() const { return ns(started, sent); }
+};
+
+struct SlowLogEntry {
+    static constexpr size_t REQUEST_LEN = 128;
+    static constexpr size_t CLIENT_LEN = 64;
+
+    uint64_t id = 0;
+    int64_t unix_time_us = 0;
+    uint64_t duration_ns = 0;
+    uint64_t parse_ns = 0;
+    uint64_t execute_ns = 0;
+    uint64_t write_ns = 0;
+    char request[REQUEST_LEN] = {};  // Start line, truncated
+    char client[CLIENT_LEN] = {};    // "ip:port"
+};
+
+// Fixed-size ring of the most recent slow requests.
+//
+// Writers never block: each claims an id with one fetch_add and fills the
+// slot under a per-slot sequence number (a seqlock). If two writers lap
+// the ring onto the same slot at once, the later one drops its entry.
+// Readers copy a slot and keep it only if its sequence did not move.
+class SlowLog {
+public:
+    static constexpr size_t CAPACITY = 128;
+    // Largest threshold that still fits in nanoseconds (about 292 years)
+    static constexpr int64_t MAX_THRESHOLD_US = INT64_MAX / 1000;
+
+    static SlowLog& instance() {
+        static SlowLog log;
+        return log;
+    }
+
+    // Requests slower than this are logged. Negative disables, 0 logs everything.
+    void set_threshold_us(int64_t us) { threshold_us_.store(us, std::memory_order_relaxed); }
+    int64_t threshold_us() const { return threshold_us_.load(std::memory_order_relaxed); }
+
+    bool is_slow(uint64_t duration_ns) const {
+        int64_t threshold = threshold_us();
+        return threshold >= 0 && duration_ns >= static_cast<uint64_t>(threshold) * 1000;
+    }
+
+    void record(const RequestTimings& t, const std::string& request, const std::string& client) {
+        uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[id % CAPACITY];
+
+        uint64_t seq = slot.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+            return; // Another writer owns this slot right now
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        SlowLogEntry& e = slot.entry;
+        e.id = id;
+        e.unix_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        e.duration_ns = t.total_ns();
+        e.parse_ns = RequestTimings::ns(t.started, t.parsed);
+        e.execute_ns = RequestTimings::ns(t.parsed, t.executed);
+        e.write_ns = RequestTimings::ns(t.executed, t.sent);
+        copy_truncated(e.request, sizeof(e.request), request);
+        copy_truncated(e.client, sizeof(e.client), client);
+
+        slot.seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Newest first, at most `count` entries
+    std::vector<SlowLogEntry> get(size_t count = CAPACITY) const {
+        std::vector<SlowLogEntry> out;
+        uint64_t reset_from = reset_from_.load(std::memory_order_relaxed);
+        for (const Slot& slot : slots_) {
+            SlowLogEntry copy;
+            if (read_slot(slot, copy) && copy.id >= reset_from) out.push_back(copy);
+        }
+        std::sort(out.begin(), out.end(),
+                  [](const SlowLogEntry& a, const SlowLogEntry& b) { return a.id > b.id; });
+        if (out.size() > count) out.resize(count);
+        return out;
+    }
+
+    size_t len() const { return get().size(); }
+
+    void reset() { reset_from_.store(next_id_.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+    // One line per entry, newest first
+    std::string format(size_t count) const {
+        std::string out;
+        char line[512];
+        for (const SlowLogEntry& e : get(count)) {
+            std::snprintf(line, sizeof(line),
+                "id=%llu time_us=%lld duration_us=%.1f parse_us=%.1f execute_us=%.1f write_us=%.1f "
+                "client=%s request=\"%s\"\n",
+                static_cast<unsigned long long>(e.id), static_cast<long long>(e.unix_time_us),
+                e.duration_ns / 1e3, e.parse_ns / 1e3, e.execute_ns / 1e3, e.write_ns / 1e3,
+                e.client, e.request);
+            out += line;
+        }
+        return out;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0}; // Odd while a writer fills the entry
+        SlowLogEntry entry;
+    };
+
+    Slot slots_[CAPACITY];
+    std::atomic<uint64_t> next_id_{1};
+    std::atomic<uint64_t> reset_from_{1};
+    std::atomic<int64_t> threshold_us_{10000};
+
+    SlowLog() = default;
+
+    static bool read_slot(const Slot& slot, SlowLogEntry& out) {
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        if (before == 0 || (before & 1)) return false;
+        std::memcpy(&out, &slot.entry, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == before;
+    }
+
+    static void copy_truncated(char* dst, size_t cap, const std::string& src) {
+        size_t n = std::min(src.size(), cap - 1);
+        std::memcpy(dst, src.data(), n);
+        dst[n] = '\0';
+    }
+};
+
+} // namespace stats
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace stats {
+
+// Every counter and gauge the server keeps. Add new entries before COUNT.
+enum Stat : size_t {
+    // Traffic
+    REQUESTS_TOTAL,
+    BYTES_RECEIVED,
+    BYTES_SENT,
+    CONNECTIONS_ACCEPTED,
+    CONNECTIONS_ACTIVE,     // gauge
+    QUEUE_DEPTH,            // gauge: accepted FDs waiting in client_queue
+
+    // Errors by type
+    ERRORS_ACCEPT,
+    ERRORS_PROTOCOL,        // request could not be parsed
+    ERRORS_HANDLER,         // exception after the request was parsed
+    ERRORS_SEND,
+
+    // Calls per route
+    CALLS_ECHO,
+    CALLS_INFO,
+    CALLS_METRICS,
+    CALLS_SLOWLOG,
+    CALLS_LATENCY,
+    CALLS_TRACE,
+    CALLS_LOGLEVEL,
+    CALLS_CLIENT,
+    CALLS_PROFILE,
+    CALLS_HWSTATS,
+    CALLS_HOTKEYS,
+
+    // Bytes currently held in client input buffers (read buffer, headers, body)
+    MEM_CLIENT_QUERY_BUF,
+    // Bytes currently held in responses that are being written out
+    MEM_CLIENT_OUTPUT_BUF,
+    // Heap trims run by idle workers (MemoryReclaimer)
+    MEM_TRIMS,
+
+    COUNT
+};
+
+// One `Shard` per thread, created the first time that thread asks for it.
+//
+// Shards are cache-line aligned and only ever written by their owning
+// thread, so the hot path touches no shared state. Readers walk every
+// shard under the registry mutex and merge on demand. Shards are never
+// freed: a thread that exits keeps its contribution in the totals.
+// There is a single registry per Shard type, reached through instance().
+template <typename Shard>
+class ThreadShards {
+    mutable std::mutex shards_mutex_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    ThreadShards() = default;
+
+public:
+    static ThreadShards& instance() {
+        static ThreadShards shards;
+        return shards;
+    }
+
+    Shard& local() {
+        thread_local Shard* shard = nullptr;
+        if (!shard) {
+            std::lock_guard<std::mutex> lock(shards_mutex_);
+            shards_.push_back(std::make_unique<Shard>());
+            shard = shards_.back().get();
+        }
+        return *shard;
+    }
+
+    // Calls fn(const Shard&) for every shard
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        for (const auto& shard : shards_) fn(*shard);
+    }
+
+    ThreadShards(const ThreadShards&) = delete;
+    ThreadShards& operator=(const ThreadShards&) = delete;
+};
+
+// Per-thread sharded counters and gauges, summed when read
+struct alignas(64) CounterShard {
+    std::atomic<int64_t> slots[Stat::COUNT] = {};
+};
+
+using ThreadCounters = ThreadShards<CounterShard>;
+
+// Only the owning thread writes its shard, so no read-modify-write is needed
+inline void add(Stat stat, int64_t delta = 1) {
+    auto& slot = ThreadCounters::instance().local().slots[stat];
+    slot.store(slot.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+inline int64_t get(Stat stat) {
+    int64_t total = 0;
+    ThreadCounters::instance().for_each([&](const CounterShard& shard) {
+        total += shard.slots[stat].load(std::memory_order_relaxed);
+    });
+    return total;
+}
+
+} // namespace stats
@@ -0,0 +1,196 @@
+#pragma once
+#include "thread_counters.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // for __rdtsc
+#endif
+
+// Sampled request tracing, exported in the Chrome / Perfetto trace format.
+//
+// One request in `sample_rate` is picked at accept time and carries a
+// trace id through client_queue. On the worker the id lives in a
+// thread-local context, and every phase boundary appends a span to that
+// thread's ring. Unsampled requests only pay a thread-local load per
+// phase boundary.
+namespace trace {
+
+enum Phase : uint8_t {
+    PHASE_ACCEPT,   // accept() returned -> FD pushed to client_queue
+    PHASE_QUEUE,    // pushed -> a worker dequeued it
+    PHASE_PARSE,    // reading and parsing the request
+    PHASE_HANDLE,   // building the response
+    PHASE_SEND,     // writing the response
+
+    PHASE_COUNT
+};
+
+inline const char* phase_name(uint8_t phase) {
+    switch (phase) {
+        case PHASE_ACCEPT: return "accept";
+        case PHASE_QUEUE: return "queue";
+        case PHASE_PARSE: return "parse";
+        case PHASE_HANDLE: return "handle";
+        case PHASE_SEND: return "send";
+        default: return "unknown";
+    }
+}
+
+// Raw timestamp: the TSC on x86, steady_clock nanoseconds elsewhere
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Maps raw timestamps to microseconds. The reference point is taken at
+// startup and the rate is measured against steady_clock when dumping.
+class TickClock {
+    uint64_t ref_ticks_;
+    std::chrono::steady_clock::time_point ref_time_;
+
+    TickClock() : ref_ticks_(now()), ref_time_(std::chrono::steady_clock::now()) {}
+
+public:
+    static TickClock& instance() {
+        static TickClock clock;
+        return clock;
+    }
+
+    double ticks_per_us() const {
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - ref_time_).count();
+        uint64_t ticks = now() - ref_ticks_;
+        return (us > 0 && ticks > 0) ? static_cast<double>(ticks) / us : 1e3;
+    }
+
+    double to_us(uint64_t ticks, double rate) const {
+        return static_cast<double>(static_cast<int64_t>(ticks - ref_ticks_)) / rate;
+    }
+};
+
+// Per-thread span ring. Only the owning thread writes; spans use relaxed
+// atomics so a concurrent dump never reads a torn value, and the dump
+// drops any slot the writer may have lapped while it was copying.
+struct alignas(64) TraceShard {
+    static constexpr size_t CAPACITY = 4096;
+
+    struct Span {
+        std::atomic<uint64_t> trace_id{0};
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> end{0};
+        std::atomic<uint8_t> phase{0};
+    };
+
+    const uint32_t tid;
+    std::atomic<uint64_t> head{0};
+    Span spans[CAPACITY];
+
+    TraceShard() : tid(next_tid()) {}
+
+    static uint32_t next_tid() {
+        static std::atomic<uint32_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+};
+
+using ThreadTraces = stats::ThreadShards<TraceShard>;
+
+// 1 in N accepted connections is traced; 0 disables tracing
+inline std::atomic<uint32_t> sample_rate{1000};
+
+// Trace id of the request this thread is working on (0 = not sampled)
+struct Context {
+    uint64_t trace_id = 0;
+    uint64_t phase_start = 0;
+};
+inline thread_local Context context;
+
+// Called at accept time; returns a trace id, or 0 if not sampled
+inline uint64_t sample() {
+    static std::atomic<uint64_t> next_id{1};
+    thread_local uint32_t countdown = 0;
+    uint32_t rate = sample_rate.load(std::memory_order_relaxed);
+    if (rate == 0) return 0;
+    if (countdown > rate) countdown = rate; // Rate was lowered since the last sample
+    if (countdown > 0 && --countdown > 0) return 0;
+    countdown = rate;
+    TickClock::instance(); // Pin the time reference before the first span
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void emit(uint64_t trace_id, Phase phase, uint64_t start, uint64_t end) {
+    TraceShard& shard = ThreadTraces::instance().local();
+    uint64_t h = shard.head.load(std::memory_order_relaxed);
+    TraceShard::Span& span = shard.spans[h % TraceShard::CAPACITY];
+    span.trace_id.store(trace_id, std::memory_order_relaxed);
+    span.start.store(start, std::memory_order_relaxed);
+    span.end.store(end, std::memory_order_relaxed);
+    span.phase.store(phase, std::memory_order_relaxed);
+    shard.head.store(h + 1, std::memory_order_release);
+}
+
+// Starts tracing `trace_id` on this thread; no-op for unsampled requests
+inline void begin(uint64_t trace_id) {
+    context.trace_id = trace_id;
+    if (trace_id) context.phase_start = now();
+}
+
+// Closes the current phase and starts the next one at the same instant
+inline void end_phase(Phase phase) {
+    if (!context.trace_id) return;
+    uint64_t t = now();
+    emit(context.trace_id, phase, context.phase_start, t);
+    context.phase_start = t;
+}
+
+inline void finish() { context.trace_id = 0; }
+
+// All retained spans as Chrome trace event JSON
+inline std::string dump_json() {
+    const TickClock& clock = TickClock::instance();
+    double rate = clock.ticks_per_us();
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char line[256];
+
+    ThreadTraces::instance().for_each([&](const TraceShard& shard) {
+        std::snprintf(line, sizeof(line),
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+            first ? "" : ",", shard.tid, shard.tid);
+        out += line;
+        first = false;
+
+        uint64_t head = shard.head.load(std::memory_order_acquire);
+        uint64_t from = head > TraceShard::CAPACITY ? head - TraceShard::CAPACITY : 0;
+        for (uint64_t i = from; i < head; ++i) {
+            const TraceShard::Span& span = shard.spans[i % TraceShard::CAPACITY];
+            uint64_t id = span.trace_id.load(std::memory_order_relaxed);
+            uint64_t start = span.start.load(std::memory_order_relaxed);
+            uint64_t end = span.end.load(std::memory_order_relaxed);
+            uint8_t phase = span.phase.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // The writer may have lapped this slot while we were reading it
+            uint64_t now_head = shard.head.load(std::memory_order_acquire);
+            if (now_head >= TraceShard::CAPACITY && i <= now_head - TraceShard::CAPACITY) continue;
+
+            std::snprintf(line, sizeof(line),
+                ",{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                "\"pid\":1,\"tid\":%u,\"args\":{\"trace_id\":%llu}}",
+                phase_name(phase), clock.to_us(start, rate),
+                end > start ? static_cast<double>(end - start) / rate : 0.0,
+                shard.tid, static_cast<unsigned long long>(id));
+            out += line;
+        }
+    });
+    out += "]}\n";
+    return out;
+}
+
+} // namespace trace
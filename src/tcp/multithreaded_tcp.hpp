@@ -3,6 +3,7 @@
 #define MULTI_THREADED_TCP_SERVER_HPP
 
 #include "tcp.hpp" // Include the base class header
+#include "../utils/memory_reclaimer.hpp"
 #include <vector>
 #include <queue>
 #include <thread>
@@ -14,14 +15,24 @@
 
 class MultiThreadedTCPServer : public TCPServer {
 private:
+    // An accepted connection waiting for a worker
+    struct QueuedClient {
+        int fd;
+        std::chrono::steady_clock::time_point accepted_at; // For queue-wait latency
+        uint64_t trace_id;      // 0 unless this connection was sampled for tracing
+        uint64_t enqueued_tick; // trace::now() when pushed, for the queue span
+        stats::ClientRegistry::Slot* client; // Registry entry, nullptr if untracked
+    };
+
     const size_t num_threads;
 
     // Thread pool components (private to this derived class)
     std::vector<std::thread> workers;
-    std::queue<int> client_queue;
+    std::queue<QueuedClient> client_queue;
     std::mutex queue_mutex;
     std::condition_variable condition;
     std::atomic<bool> stop_requested{false}; // Use a different name to avoid confusion
+    MemoryReclaimer reclaimer; // Idle workers return freed heap pages to the OS
 
     // Override logging to add derived class identifier
     void log(const std::string& message) override {
@@ -36,15 +47,31 @@ private:
 
 
     // Function executed by worker threads
-    void worker_thread() {
+    void worker_thread(int index) {
         log("Worker thread started. ID: " + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())));
         while (true) {
             int client_fd = -1; // Initialize to invalid FD
+            uint64_t trace_id = 0;
+            uint64_t enqueued_tick = 0;
+            stats::ClientRegistry::Slot* client = nullptr;
 
             
             { 
                 std::unique_lock<std::mutex> lock(queue_mutex);
-                condition.wait(lock, [this] { return !client_queue.empty() || stop_requested; });
+                bool woken = condition.wait_for(lock, MemoryReclaimer::IDLE_TICK,
+                    [this] { return !client_queue.empty() || stop_requested; });
+
+                if (!woken) {
+                    // Idle tick: no work arrived, offer to reclaim memory outside the lock
+                    lock.unlock();
+                    if (reclaimer.on_idle()) {
+                        stats::add(stats::MEM_TRIMS);
+                        stats::LatencyMonitor::instance().record(stats::EVENT_MALLOC_TRIM,
+                            static_cast<uint64_t>(reclaimer.last_duration_us()));
+                        DEBUG("Worker thread trimmed heap, took (us):", reclaimer.last_duration_us());
+                    }
+                    continue;
+                }
 
                 
                 if (stop_requested && client_queue.empty()) {
@@ -54,8 +81,13 @@ private:
 
                 // Check if queue has work before accessing front()
                 if (!client_queue.empty()) {
-                    client_fd = client_queue.front();
+                    client_fd = client_queue.front().fd;
+                    trace_id = client_queue.front().trace_id;
+                    enqueued_tick = client_queue.front().enqueued_tick;
+                    client = client_queue.front().client;
+                    stats::record_latency(stats::QUEUE_WAIT, stats::elapsed_ns(client_queue.front().accepted_at));
                     client_queue.pop();
+                    stats::add(stats::QUEUE_DEPTH, -1);
                     DEBUG("Worker thread picked up client FD:", client_fd);
                 } else {
                     // Spurious wakeup or stop requested but queue became empty
@@ -69,6 +101,10 @@ private:
             if (client_fd >= 0) {
                 log("Worker thread handling connection for FD " + std::to_string(client_fd));
 
+                if (trace_id) trace::emit(trace_id, trace::PHASE_QUEUE, enqueued_tick, trace::now());
+                trace::begin(trace_id);
+                stats::ClientRegistry::bind(client, index);
+
                 try {
                     TCPServer::handle_connection(client_fd); 
                 } catch (const std::exception& e) {
@@ -77,7 +113,11 @@ private:
                      log_error("Worker thread caught unknown unhandled exception from handle_connection.");
                 }
 
+                trace::finish();
+                stats::ClientRegistry::unbind();
+                stats::ClientRegistry::instance().close(client);
                 TCPServer::close_socket(client_fd);
+                stats::add(stats::CONNECTIONS_ACTIVE, -1);
                 log("Worker thread finished and closed FD " + std::to_string(client_fd));
             }
         }
@@ -121,7 +161,7 @@ public:
         workers.reserve(num_threads);
         log("Starting " + std::to_string(num_threads) + " worker threads...");
         for (size_t i = 0; i < num_threads; ++i) {
-            workers.emplace_back(&MultiThreadedTCPServer::worker_thread, this);
+            workers.emplace_back(&MultiThreadedTCPServer::worker_thread, this, static_cast<int>(i));
         }
         log("Multi-threaded server started successfully.");
     }
@@ -142,6 +182,7 @@ public:
 
             // Accept connection (blocking call on base server_fd)
              DEBUG("Main thread waiting on accept()...");
+            auto accept_started = std::chrono::steady_clock::now();
             int client_fd = accept(server_fd, (sockaddr*)&client_addr, &client_len);
 
             if (client_fd < 0) {
@@ -154,7 +195,14 @@ public:
                 if (errno == EINTR) {
                     DEBUG("accept() interrupted by signal, continuing...");
                     continue; // Interrupted by signal, just retry
-                } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                }
+                stats::add(stats::ERRORS_ACCEPT);
+                // Only the failed call itself is the stall, not the back-off sleep below
+                int accept_errno = errno;
+                stats::LatencyMonitor::instance().record(stats::EVENT_ACCEPT_ERROR,
+                    stats::elapsed_ns(accept_started) / 1000);
+                errno = accept_errno;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
                      // Should not happen with blocking sockets, but log if it does
                      log_error("accept() returned EAGAIN/EWOULDBLOCK unexpectedly.");
                      std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Avoid busy loop
@@ -175,9 +223,19 @@ public:
                 + std::to_string(ntohs(client_addr.sin_port)) + " [FD: " + std::to_string(client_fd) + "]");
 
             
+            stats::add(stats::CONNECTIONS_ACCEPTED);
+            stats::add(stats::CONNECTIONS_ACTIVE);
+            stats::ClientRegistry::Slot* client = stats::ClientRegistry::instance().open(client_fd,
+                std::string(client_ip) + ":" + std::to_string(ntohs(client_addr.sin_port)));
+            uint64_t trace_id = trace::sample();
+            uint64_t accepted_tick = trace_id ? trace::now() : 0;
+
             { // add client_fd by taking RAII lock 
                 std::lock_guard<std::mutex> lock(queue_mutex);
-                client_queue.push(client_fd);
+                uint64_t enqueued_tick = trace_id ? trace::now() : 0;
+                client_queue.push({client_fd, std::chrono::steady_clock::now(), trace_id, enqueued_tick, client});
+                if (trace_id) trace::emit(trace_id, trace::PHASE_ACCEPT, accepted_tick, enqueued_tick);
+                stats::add(stats::QUEUE_DEPTH);
                 DEBUG("Pushed client FD to queue:", client_fd);
             } 
 
@@ -225,8 +283,11 @@ public:
          // Clear the queue (optional, threads should have processed/exited)
          std::lock_guard<std::mutex> lock(queue_mutex);
          while(!client_queue.empty()) {
-             int fd = client_queue.front();
+             int fd = client_queue.front().fd;
+             stats::ClientRegistry::instance().close(client_queue.front().client);
              client_queue.pop();
+             stats::add(stats::QUEUE_DEPTH, -1);
+             stats::add(stats::CONNECTIONS_ACTIVE, -1);
              log_error("Found unprocessed FD in queue during stop: " + std::to_string(fd) + ". Closing.");
              TCPServer::close_socket(fd); // Close any leftover FDs
          }
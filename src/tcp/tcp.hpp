@@ -20,6 +20,14 @@
 
 #include "../utils/http_message.hpp" 
 #include "../debug/debug.hpp"       
+#include "../admin/admin_routes.hpp"
+#include "../stats/memory_stats.hpp"
+#include "../stats/latency.hpp"
+#include "../stats/slowlog.hpp"
+#include "../stats/latency_monitor.hpp"
+#include "../stats/trace.hpp"
+#include "../stats/hw_counters.hpp"
+#include "../stats/hotkeys.hpp"
 
 class TCPServer {
 protected: 
@@ -51,16 +59,87 @@ protected:
         throw std::system_error(errno, std::generic_category(), "[TCPBase] " + msg + ": " + strerror(errno));
     }
 
+    // Buffers at least this large are timed when released
+    static constexpr size_t LARGE_FREE_BYTES = 1024 * 1024;
+
+    // Frees `buffer` now, reporting large releases to the latency monitor
+    static void release_buffer(std::vector<char>& buffer) {
+        if (buffer.capacity() < LARGE_FREE_BYTES) {
+            std::vector<char>().swap(buffer);
+            return;
+        }
+        auto started = std::chrono::steady_clock::now();
+        std::vector<char>().swap(buffer);
+        stats::LatencyMonitor::instance().record(stats::EVENT_LARGE_FREE,
+            stats::elapsed_ns(started) / 1000);
+    }
+
+    // "ip:port" of the connected peer, or "?" if it cannot be determined
+    static std::string peer_address(int fd) {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (getpeername(fd, (sockaddr*)&addr, &len) < 0) return "?";
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &addr.sin_addr, ip, INET_ADDRSTRLEN);
+        return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    // Bookkeeping once a response has been sent
+    void finish_request(int client_fd, const HttpMessage& request, stats::Timer route_timer,
+                        const stats::RequestTimings& timings) {
+        uint64_t total_ns = timings.total_ns();
+        stats::record_latency(route_timer, total_ns);
+
+        auto& slowlog = stats::SlowLog::instance();
+        if (slowlog.is_slow(total_ns)) {
+            slowlog.record(timings, request.start_line, peer_address(client_fd));
+        }
+    }
+
     // Core connection handling logic (intended to be blocking)
     virtual void handle_connection(int client_fd) {
+        bool parsed = false; // Tells protocol errors apart from handler errors
+        stats::RequestTimings timings;
+        timings.started = std::chrono::steady_clock::now();
+        stats::HwSample hw; // Hardware counters, for one request in hw_sample_rate
         try {
             DEBUG("Base handler started for FD:", client_fd);
 
             // 1. Parse request (blocking read)
             HttpMessage request = HttpMessage::parse(client_fd);
+            parsed = true;
+            timings.parsed = std::chrono::steady_clock::now();
+            trace::end_phase(trace::PHASE_PARSE);
+            hw.mark(stats::HW_PARSE);
+            stats::add(stats::REQUESTS_TOTAL);
+            stats::ClientRegistry::on_command(request.method(), request.path());
             DEBUG("Parsed request", request.headers, request.start_line);
 
-            
+            size_t request_bytes = request.start_line.size() + request.body.capacity();
+            for (const auto& [key, value] : request.headers) request_bytes += key.size() + value.size();
+            stats::MemoryCharge query_charge(stats::MEM_CLIENT_QUERY_BUF, request_bytes);
+
+            // 2. Admin endpoints answer with their own response
+            std::string admin_response;
+            stats::Timer route_timer = stats::ROUTE_ECHO;
+            if (admin::dispatch(request, admin_response, route_timer)) {
+                timings.executed = std::chrono::steady_clock::now();
+                trace::end_phase(trace::PHASE_HANDLE);
+                hw.mark(stats::HW_HANDLE);
+                stats::MemoryCharge output_charge(stats::MEM_CLIENT_OUTPUT_BUF, admin_response.size());
+                if (!send_all(client_fd, admin_response.data(), admin_response.size())) {
+                    log_error("Failed to send admin response to FD " + std::to_string(client_fd));
+                }
+                timings.sent = std::chrono::steady_clock::now();
+                trace::end_phase(trace::PHASE_SEND);
+                hw.commit(route_timer);
+                finish_request(client_fd, request, route_timer, timings);
+                return;
+            }
+
+            stats::add(stats::CALLS_ECHO);
+            stats::record_key_access(request.path()); // The path is the key on the data route
+            stats::MemoryCharge output_charge(stats::MEM_CLIENT_OUTPUT_BUF, request.body.size());
             std::vector<char> body_to_send = request.body; 
             std::string response_body_str(body_to_send.begin(), body_to_send.end()); 
             std::string headers =
@@ -71,6 +150,9 @@ protected:
 
             DEBUG("Base handler sending response headers:", headers);
             DEBUG("Base handler sending response body:", response_body_str);
+            timings.executed = std::chrono::steady_clock::now();
+            trace::end_phase(trace::PHASE_HANDLE);
+            hw.mark(stats::HW_HANDLE);
 
             // 3. Send response (blocking write)
             if (!send_all(client_fd, headers.data(), headers.size()) ||
@@ -79,8 +161,15 @@ protected:
             } else {
                  DEBUG("Base handler response sent successfully to FD:", client_fd);
             }
+            timings.sent = std::chrono::steady_clock::now();
+            trace::end_phase(trace::PHASE_SEND);
+            hw.commit(route_timer);
+            finish_request(client_fd, request, route_timer, timings);
+            release_buffer(body_to_send);
+            release_buffer(request.body);
 
         } catch (const std::exception &e) {
+            stats::add(parsed ? stats::ERRORS_HANDLER : stats::ERRORS_PROTOCOL);
             log_error("Exception during base handle_connection for FD " + std::to_string(client_fd) + ": " + e.what());
              
             try {
@@ -89,6 +178,7 @@ protected:
             } catch(...) { /* Ignore errors during error reporting */ }
             
         } catch (...) {
+             stats::add(parsed ? stats::ERRORS_HANDLER : stats::ERRORS_PROTOCOL);
              log_error("Unknown exception during base handle_connection for FD " + std::to_string(client_fd));
              
             try {
@@ -106,6 +196,7 @@ protected:
         while (total_sent < length) {
             ssize_t sent = send(socket, data + total_sent, length - total_sent, MSG_NOSIGNAL);
             if (sent == -1) {
+                stats::add(stats::ERRORS_SEND);
                 if (errno == EPIPE || errno == ECONNRESET) {
                     log_error("Send failed: Client disconnected (FD: " + std::to_string(socket) + ")");
                 } else {
@@ -114,11 +205,13 @@ protected:
                 return false;
             }
              if (sent == 0) {
-                
+                stats::add(stats::ERRORS_SEND);
                 log_error("Send returned 0 unexpectedly on FD " + std::to_string(socket));
                 return false;
             }
             total_sent += sent;
+            stats::add(stats::BYTES_SENT, sent);
+            stats::ClientRegistry::on_bytes_out(static_cast<uint64_t>(sent));
         }
         DEBUG("Sent", total_sent, "bytes to FD:", socket);
         return true;
@@ -193,15 +286,18 @@ public:
 
             // Accept connection (blocking)
             DEBUG("Base run() waiting on accept()...");
+            auto accept_started = std::chrono::steady_clock::now();
             int client_fd = accept(server_fd, (sockaddr*)&client_addr, &client_len);
             if (client_fd < 0) {
-                
+                 stats::add(stats::ERRORS_ACCEPT);
                  log_error("accept failed: " + std::string(strerror(errno)));
                  // In a real scenario, might need more robust handling (e.g., check for EINTR)
                  // or maybe just break the loop on severe errors.
                  // For simplicity here, we log and continue.
                  if(errno == EINVAL || errno == EBADF || errno == ENOTSOCK) break; // Non-recoverable?
                  std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Avoid busy loop on some errors
+                 stats::LatencyMonitor::instance().record(stats::EVENT_ACCEPT_ERROR,
+                     stats::elapsed_ns(accept_started) / 1000);
                 continue;
             }
 
@@ -211,6 +307,13 @@ public:
             log("Connection accepted from " + std::string(client_ip) + ":"
                 + std::to_string(ntohs(client_addr.sin_port)) + " [FD: " + std::to_string(client_fd) + "]");
 
+            stats::add(stats::CONNECTIONS_ACCEPTED);
+            stats::add(stats::CONNECTIONS_ACTIVE);
+            auto& clients = stats::ClientRegistry::instance();
+            stats::ClientRegistry::Slot* client = clients.open(client_fd,
+                std::string(client_ip) + ":" + std::to_string(ntohs(client_addr.sin_port)));
+            stats::ClientRegistry::bind(client, 0);
+
             // Handle connection IN THE SAME THREAD
             try {
                 handle_connection(client_fd);
@@ -222,7 +325,10 @@ public:
 
 
             // Close connection IN THE SAME THREAD
+            stats::ClientRegistry::unbind();
+            clients.close(client);
             close_socket(client_fd);
+            stats::add(stats::CONNECTIONS_ACTIVE, -1);
             log("Connection closed for FD " + std::to_string(client_fd));
         }
         log("Base run loop finished."); 
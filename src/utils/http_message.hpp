@@ -32,7 +32,42 @@ struct HttpMessage {
         return msg;
     }
 
+    // Request method from the start line, e.g. "GET"
+    std::string method() const {
+        return start_line.substr(0, start_line.find(' '));
+    }
+
+    // Request target without the query string, e.g. "/info"
+    std::string path() const {
+        std::string target = this->target();
+        return target.substr(0, target.find('?'));
+    }
+
+    // Value of `name` in the query string, or `fallback` if absent
+    std::string query_param(const std::string& name, const std::string& fallback = "") const {
+        std::string target = this->target();
+        size_t q = target.find('?');
+        while (q != std::string::npos) {
+            size_t start = q + 1;
+            size_t end = target.find('&', start);
+            std::string pair = target.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            size_t eq = pair.find('=');
+            if (pair.substr(0, eq) == name) {
+                return eq == std::string::npos ? "" : pair.substr(eq + 1);
+            }
+            q = end;
+        }
+        return fallback;
+    }
+
 private:
+    std::string target() const {
+        size_t start = start_line.find(' ');
+        if (start == std::string::npos) return "";
+        size_t end = start_line.find(' ', start + 1);
+        return start_line.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+    }
+
     static void parse_start_line(const std::string& data, HttpMessage& msg) {
         size_t end = data.find("\r\n");
         if (end == std::string::npos) throw std::runtime_error("Invalid HTTP format");
@@ -6,24 +6,26 @@
 #include <unistd.h>
 #include <sys/uio.h>  // for readv
 #include <algorithm>
+#include "../stats/memory_stats.hpp"
 
 class HttpReader {
     int fd_;
     std::vector<char> buffer_;
     size_t bufflen_ = 0;
     size_t pos_ = 0;
+    stats::MemoryCharge charge_; // Counts buffer_ as client query memory
     static const size_t DEFAULT_BUFSIZE = 16 * 1024; // 16KB buffer
 
 public:
     explicit HttpReader(int fd, size_t buf_size = DEFAULT_BUFSIZE) 
-        : fd_(fd), buffer_(buf_size) {}
+        : fd_(fd), buffer_(buf_size), charge_(stats::MEM_CLIENT_QUERY_BUF, buf_size) {}
 
     // Optimized: Reads until delimiter with buffering
     std::string read_until(const std::string& delimiter) {
         std::string result;
         while (true) {
             // Refill buffer if needed
-            if (pos_ >= buffer_.size()) {
+            if (pos_ >= bufflen_) {
                 refill_buffer();
                 if(bufflen_ == 0) break; // EOF 
             }
@@ -44,7 +46,7 @@ public:
 
             // Append partial data
             result.append(start, remaining);
-            pos_ = buffer_.size(); // Force refill
+            pos_ = bufflen_; // Force refill
         }
         return result;
     }
@@ -55,7 +57,7 @@ public:
         result.reserve(length);
 
         while (result.size() < length) {
-            if (pos_ >= buffer_.size()) {
+            if (pos_ >= bufflen_) {
                 refill_buffer();
                 if (bufflen_ == 0) break; // EOF
             }
@@ -112,5 +114,7 @@ private:
         ssize_t n = read(fd_, buffer_.data(), buffer_.size());
         if (n < 0) throw std::runtime_error("Read error");
         bufflen_ = n;
+        stats::add(stats::BYTES_RECEIVED, n);
+        stats::ClientRegistry::on_bytes_in(static_cast<uint64_t>(n));
     }
 };
\ No newline at end of file
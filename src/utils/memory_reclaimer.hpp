@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#if defined(__GLIBC__)
+#include <malloc.h>   // for malloc_trim
+#endif
+
+// Hands free heap pages back to the OS while the server is idle.
+//
+// Large request bodies grow the allocator's heap; once they are freed the
+// pages stay mapped, so RSS sits well above what is actually live. Idle
+// workers call on_idle(), and at most one of them at a time runs a trim.
+// The pause before the next trim scales with how long the last one took,
+// which keeps the reclaimer inside a fixed share of one core.
+class MemoryReclaimer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // How often an idle worker wakes up to offer a reclaim tick.
+    static constexpr std::chrono::milliseconds IDLE_TICK{250};
+    // Shortest gap between two trims, whatever the budget allows.
+    static constexpr std::chrono::milliseconds MIN_INTERVAL{1000};
+    // Share of wall time the trims may use: 1 / BUDGET_DIVISOR.
+    static constexpr long BUDGET_DIVISOR = 100;
+
+    // Returns true if this call performed a trim.
+    bool on_idle() {
+        auto now = clock::now().time_since_epoch().count();
+        if (now < next_run_.load(std::memory_order_relaxed)) return false;
+
+        bool expected = false;
+        if (!running_.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return false; // Another worker is already trimming
+        }
+
+        auto started = clock::now();
+        trim();
+        auto took = clock::now() - started;
+
+        auto pause = std::max<clock::duration>(MIN_INTERVAL, took * BUDGET_DIVISOR);
+        next_run_.store((clock::now() + pause).time_since_epoch().count(), std::memory_order_relaxed);
+        last_duration_us_.store(
+            std::chrono::duration_cast<std::chrono::microseconds>(took).count(),
+            std::memory_order_relaxed);
+
+        running_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    long last_duration_us() const { return last_duration_us_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> running_{false};
+    std::atomic<clock::rep> next_run_{0};
+    std::atomic<long> last_duration_us_{0};
+
+    static void trim() {
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+    }
+};
@@ -0,0 +1,56 @@
+// HttpReader against a pipe that hands data over in several short reads
+#include "../src/utils/http_reader.hpp"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+static void put(int fd, const char* data) {
+    if (write(fd, data, std::strlen(data)) != static_cast<ssize_t>(std::strlen(data))) {
+        std::perror("write");
+    }
+}
+
+int main() {
+    alarm(5); // A reader that stops refilling spins instead of failing
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::perror("pipe");
+        return 1;
+    }
+    HttpReader reader(fds[0]);
+
+    // Each read() returns only what has been written so far, well short of the buffer
+    put(fds[1], "GET / HTTP/1.1\r\nContent-");
+    put(fds[1], "Length: 10\r\n\r\nhello");
+    check(reader.read_until("\r\n") == "GET / HTTP/1.1\r\n", "request line");
+    check(reader.read_until("\r\n") == "Content-Length: 10\r\n", "header split over two reads");
+    check(reader.read_until("\r\n") == "\r\n", "end of headers");
+
+    put(fds[1], "world");
+    close(fds[1]);
+    std::vector<char> body = reader.read_fixed(10);
+    check(std::string(body.begin(), body.end()) == "helloworld", "body split over two reads");
+
+    bool threw = false;
+    try {
+        reader.read_fixed(1);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    check(threw, "read past EOF throws");
+
+    close(fds[0]);
+    if (failures == 0) std::printf("http_reader_test: ok\n");
+    return failures == 0 ? 0 : 1;
+}